@@ -0,0 +1,34 @@
+#include "bench.hh"
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace reefscape::bench {
+
+void Suite::Print(const Result &result) {
+  std::cout << std::left << std::setw(40) << result.name << std::right
+            << std::fixed << std::setprecision(1) << std::setw(10)
+            << result.median_ns << " ns median" << std::setw(10)
+            << result.p99_ns << " ns p99" << std::setw(14)
+            << std::setprecision(0) << result.OpsPerSecond() << " ops/s"
+            << std::endl;
+}
+
+void Suite::WriteJson(const std::string &path) const {
+  std::ofstream file{path};
+  file << "{\"benchmarks\": [";
+  for (std::size_t i = 0; i < results_.size(); ++i) {
+    const Result &result = results_[i];
+    file << (i == 0 ? "\n" : ",\n") << "  {\"name\": \"" << result.name
+         << "\", \"samples\": " << result.samples
+         << ", \"batch_size\": " << result.batch_size
+         << ", \"mean_ns\": " << result.mean_ns
+         << ", \"median_ns\": " << result.median_ns
+         << ", \"p99_ns\": " << result.p99_ns
+         << ", \"ops_per_second\": " << result.OpsPerSecond() << "}";
+  }
+  file << "\n]}\n";
+}
+
+}  // namespace reefscape::bench
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <numeric>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace reefscape::bench {
+
+// NOTE(hayden): Forces `value` to be materialized in memory, so the compiler
+// can neither discard the computation that produced it nor hoist it out of the
+// measurement loop
+template <typename T>
+inline void DoNotOptimize(const T &value) {
+  asm volatile("" : : "m"(value) : "memory");
+}
+
+// Also makes the compiler assume `value` was modified, so computations on it
+// are redone every iteration
+template <typename T>
+inline void DoNotOptimize(T &value) {
+  asm volatile("" : "+m"(value) : : "memory");
+}
+
+struct Result {
+  std::string name;
+  std::size_t samples;
+  std::size_t batch_size;
+  double mean_ns;
+  double median_ns;
+  double p99_ns;
+
+  double OpsPerSecond() const { return 1e9 / mean_ns; }
+};
+
+class Suite {
+ public:
+  Suite(std::string filter, std::size_t samples)
+      : filter_(std::move(filter)), samples_(samples) {}
+
+  // Times `operation` in batches long enough to swamp clock overhead and
+  // records per-operation statistics across batches
+  template <typename Operation>
+  void Run(const std::string &name, Operation &&operation) {
+    if (!filter_.empty() && name.find(filter_) == std::string::npos) {
+      return;
+    }
+
+    using Clock = std::chrono::steady_clock;
+    auto time_batch = [&operation](std::size_t batch_size) {
+      auto start = Clock::now();
+      for (std::size_t i = 0; i < batch_size; ++i) {
+        operation();
+      }
+      return std::chrono::duration<double, std::nano>(Clock::now() - start)
+          .count();
+    };
+
+    std::size_t batch_size = 1;
+    while (time_batch(batch_size) < kMinBatchNanoseconds &&
+           batch_size < kMaxBatchSize) {
+      batch_size *= 2;
+    }
+
+    std::vector<double> per_op_ns(samples_);
+    for (double &sample : per_op_ns) {
+      sample = time_batch(batch_size) / batch_size;
+    }
+    std::sort(per_op_ns.begin(), per_op_ns.end());
+
+    Result result{
+        name,
+        samples_,
+        batch_size,
+        std::accumulate(per_op_ns.begin(), per_op_ns.end(), 0.0) / samples_,
+        per_op_ns[samples_ / 2],
+        per_op_ns[std::min(samples_ - 1, samples_ * 99 / 100)]};
+    Print(result);
+    results_.push_back(result);
+  }
+
+  const std::vector<Result> &Results() const { return results_; }
+
+  void WriteJson(const std::string &path) const;
+
+ private:
+  static constexpr double kMinBatchNanoseconds = 20'000;
+  static constexpr std::size_t kMaxBatchSize = std::size_t{1} << 30;
+
+  static void Print(const Result &result);
+
+  std::string filter_;
+  std::size_t samples_;
+  std::vector<Result> results_;
+};
+
+}  // namespace reefscape::bench
@@ -0,0 +1,219 @@
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "AffineSystemSim.hh"
+#include "Arm.hh"
+#include "AsyncPublisher.hh"
+#include "Eigen.hh"
+#include "Elevator.hh"
+#include "Motor.hh"
+#include "MotorSystem.hh"
+#include "MotorSystemConstants.hh"
+#include "NonlinearSystemSim.hh"
+#include "au/units/amperes.hh"
+#include "au/units/inches.hh"
+#include "au/units/pounds_mass.hh"
+#include "bench.hh"
+#include "input.hh"
+#include "ntcore_cpp.h"
+#include "pubsub.hh"
+#include "robot.hh"
+#include "sample.hh"
+#include "state.hh"
+#include "trajectory.hh"
+#include "units.hh"
+
+using namespace reefscape;
+using namespace reefscape::bench;
+using State = PositionVelocityState;
+using Input = VoltageInput;
+
+struct Options {
+  std::string filter;
+  std::size_t samples = 1000;
+  std::string json;
+};
+
+Options ParseOptions(int argc, char *argv[]) {
+  Options options;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg = argv[i];
+    if (arg == "--filter" && i + 1 < argc) {
+      options.filter = argv[++i];
+    } else if (arg == "--samples" && i + 1 < argc) {
+      options.samples = std::max(1, std::atoi(argv[++i]));
+    } else if (arg == "--json" && i + 1 < argc) {
+      options.json = argv[++i];
+    } else {
+      std::cerr << "usage: " << argv[0]
+                << " [--filter SUBSTRING] [--samples N] [--json FILE]"
+                << std::endl;
+      std::exit(EXIT_FAILURE);
+    }
+  }
+
+  return options;
+}
+
+int main(int argc, char *argv[]) {
+  Options options = ParseOptions(argc, argv);
+  Suite suite{options.filter, options.samples};
+
+  Elevator elevator{units::gear_ratio(5), 0.5 * au::inches(1.273),
+                    au::pounds_mass(30),  au::amperes(120),
+                    kTotalTravel,         Motor::KrakenX60FOC() * 2};
+  Time time_step = (au::milli(au::seconds))(1);
+  LinearAcceleration gravity = (au::meters / squared(au::second))(-9.81);
+
+  auto continuous_matrices =
+      std::make_pair(elevator.ContinuousSystemMatrix<State>(),
+                     elevator.ContinuousInputMatrix<State, Input>());
+  suite.Run("Discretize", [&] {
+    DoNotOptimize(continuous_matrices);
+    DoNotOptimize(Discretize(continuous_matrices, time_step));
+  });
+
+  suite.Run("PseudoInverse", [&] {
+    DoNotOptimize(continuous_matrices);
+    DoNotOptimize(PseudoInverse(continuous_matrices.second));
+  });
+
+  AffineSystemSim<State, Input> sim{elevator, gravity, time_step};
+  Input input{sim.StabilizingInput()};
+  suite.Run("AffineSystemSim::Update", [&] {
+    DoNotOptimize(input);
+    sim.Update(input);
+    DoNotOptimize(sim);
+  });
+
+  // NOTE(hayden): A uniform 4 kg, 20 in arm pivoting at one end; each update
+  // starts from horizontal so adaptive runs take the same steps every time
+  Displacement arm_length = au::inches(20);
+  Mass arm_mass = au::kilo(au::grams)(4);
+  Arm arm{units::gear_ratio(50),
+          arm_length,
+          arm_mass * arm_length * arm_length / 3,
+          arm_mass,
+          arm_length / 2,
+          au::amperes(40),
+          Motor::KrakenX60FOC()};
+  NonlinearSystemSim<Arm, units::AngleUnit, ArmGravity> arm_sim{
+      arm, ArmGravity{arm, gravity}};
+  Voltage arm_voltage = au::volts(6.0);
+  auto run_arm_sim = [&](const std::string &name, Integrator integrator) {
+    arm_sim.SetIntegrator(integrator);
+    suite.Run(name, [&] {
+      DoNotOptimize(arm_voltage);
+      arm_sim.SetState(au::radians(0), (au::radians / au::second)(0));
+      arm_sim.Update(arm_voltage, time_step);
+      DoNotOptimize(arm_sim);
+    });
+  };
+  run_arm_sim("NonlinearSystemSim::Update/RK4", Integrator::kRK4);
+  run_arm_sim("NonlinearSystemSim::Update/DormandPrince",
+              Integrator::kDormandPrince);
+
+  // The same arm with payloads spread across an ensemble, stepped at once
+  const int arm_members = 256;
+  Eigen::ArrayXd arm_velocity_coefficients(arm_members);
+  Eigen::ArrayXd arm_voltage_coefficients(arm_members);
+  ArmEnsembleGravity arm_ensemble_gravity{Eigen::ArrayXd(arm_members)};
+  for (int member = 0; member < arm_members; ++member) {
+    Mass member_mass =
+        arm_mass + au::kilo(au::grams)(2.0) * member / (arm_members - 1);
+    Arm member_arm = arm;
+    member_arm.mass = member_mass;
+    member_arm.moment_of_inertia = member_mass * arm_length * arm_length / 3;
+    arm_velocity_coefficients[member] = member_arm.VelocityCoefficient().in(
+        units::AngularVelocityCoefficientUnit{});
+    arm_voltage_coefficients[member] = member_arm.VoltageCoefficient().in(
+        units::AngularVoltageCoefficientUnit{});
+    arm_ensemble_gravity.coefficient[member] =
+        ArmGravity{member_arm, gravity}.coefficient;
+  }
+  NonlinearEnsembleSim arm_ensemble{arm_velocity_coefficients,
+                                    arm_voltage_coefficients,
+                                    arm_ensemble_gravity};
+  arm_ensemble.Voltage().setConstant(arm_voltage.in(au::volts));
+  suite.Run("NonlinearEnsembleSim::Update/RK4", [&] {
+    arm_ensemble.Position().setZero();
+    arm_ensemble.Velocity().setZero();
+    arm_ensemble.Update(time_step);
+    DoNotOptimize(arm_ensemble);
+  });
+
+  TrapezoidTrajectory<units::DisplacementUnit> profile{elevator};
+  State bottom{au::meters(0)};
+  State top{kTotalTravel};
+  suite.Run("TrapezoidTrajectory::Calculate", [&] {
+    DoNotOptimize(bottom);
+    DoNotOptimize(profile.Calculate(time_step, bottom, top));
+  });
+
+  LinearVelocity velocity = (au::meters / au::second)(1.0);
+  Voltage voltage = au::volts(12.0);
+  suite.Run("LimitVoltage", [&] {
+    DoNotOptimize(velocity);
+    DoNotOptimize(voltage);
+    DoNotOptimize(LimitVoltage(elevator, velocity, voltage));
+  });
+
+  suite.Run("Current", [&] {
+    DoNotOptimize(velocity);
+    DoNotOptimize(voltage);
+    DoNotOptimize(reefscape::Current(elevator, velocity, voltage));
+  });
+
+  MotorSystemConstants<units::DisplacementUnit> motor_constants{elevator};
+  suite.Run("LimitVoltage/constants", [&] {
+    DoNotOptimize(velocity);
+    DoNotOptimize(voltage);
+    DoNotOptimize(LimitVoltage(motor_constants, velocity, voltage));
+  });
+
+  suite.Run("Current/constants", [&] {
+    DoNotOptimize(velocity);
+    DoNotOptimize(voltage);
+    DoNotOptimize(reefscape::Current(motor_constants, velocity, voltage));
+  });
+
+  // Hand-written double arithmetic as a floor for the typed versions above
+  double raw_velocity = velocity.in(au::meters / au::second);
+  double raw_voltage = voltage.in(au::volts);
+  double raw_nominal_voltage = motor_constants.nominal_voltage.in(au::volts);
+  double raw_back_emf_coefficient = motor_constants.back_emf_coefficient.in(
+      au::volts / (au::meters / au::second));
+  double raw_current_limit_voltage =
+      motor_constants.current_limit_voltage.in(au::volts);
+  suite.Run("LimitVoltage/raw", [&] {
+    DoNotOptimize(raw_velocity);
+    DoNotOptimize(raw_voltage);
+    double limited = std::clamp(raw_voltage, -raw_nominal_voltage,
+                                raw_nominal_voltage);
+    double back_emf = raw_back_emf_coefficient * raw_velocity;
+    limited = std::min(limited, raw_current_limit_voltage + back_emf);
+    DoNotOptimize(limited);
+  });
+
+  auto instance = nt::CreateInstance();
+  {
+    Publisher publisher{instance};
+    auto sample = Sample::From(time_step, top, bottom, input, false);
+    suite.Run("Publisher::Publish", [&] { publisher.Publish(sample); });
+  }
+  {
+    AsyncPublisher publisher{Publisher{instance}};
+    auto sample = Sample::From(time_step, top, bottom, input, false);
+    suite.Run("AsyncPublisher::Publish", [&] { publisher.Publish(sample); });
+  }
+  nt::DestroyInstance(instance);
+
+  if (!options.json.empty()) {
+    suite.WriteJson(options.json);
+  }
+}
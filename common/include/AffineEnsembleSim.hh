@@ -0,0 +1,218 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "Eigen.hh"
+#include "Elevator.hh"
+#include "MotorSystem.hh"
+#include "MotorSystemConstants.hh"
+#include "units.hh"
+
+namespace reefscape {
+
+using namespace quantities;
+
+// NOTE(hayden): Ensemble arrays are column-major with one row per member, so
+// each column is one scalar of every member stored contiguously
+// (struct-of-arrays). Column-wise expressions vectorize across the ensemble.
+template <int Columns>
+using EnsembleArray = Eigen::Array<double, Eigen::Dynamic, Columns>;
+
+// Per-member MotorSystemConstants of an ensemble of motor systems, in volts
+// and NativeUnit per second
+struct EnsembleMotorConstants {
+  Eigen::ArrayXd nominal_voltage;
+  Eigen::ArrayXd back_emf_coefficient;
+  Eigen::ArrayXd current_limit_voltage;
+
+  template <typename NativeUnit, typename System>
+    requires MotorSystem<System, NativeUnit>
+  static EnsembleMotorConstants From(const std::vector<System> &systems) {
+    const int size = static_cast<int>(systems.size());
+    EnsembleMotorConstants result{Eigen::ArrayXd(size), Eigen::ArrayXd(size),
+                                  Eigen::ArrayXd(size)};
+
+    for (int i = 0; i < size; ++i) {
+      MotorSystemConstants<NativeUnit> constants{systems[i]};
+      result.nominal_voltage[i] = constants.nominal_voltage.in(au::volts);
+      result.back_emf_coefficient[i] = constants.back_emf_coefficient.in(
+          units::VoltageUnit{} / units::Velocity<NativeUnit>{});
+      result.current_limit_voltage[i] =
+          constants.current_limit_voltage.in(au::volts);
+    }
+
+    return result;
+  }
+};
+
+// Batched equivalent of LimitVoltage with MotorSystemConstants, updating every
+// member's voltage in place
+inline void LimitVoltage(const EnsembleMotorConstants &constants,
+                         const Eigen::Ref<const Eigen::ArrayXd> &velocity,
+                         Eigen::Ref<Eigen::ArrayXd> voltage) {
+  voltage =
+      voltage.max(-constants.nominal_voltage).min(constants.nominal_voltage);
+
+  auto back_emf = constants.back_emf_coefficient * velocity;
+  voltage = (voltage - back_emf > constants.current_limit_voltage)
+                .select(constants.current_limit_voltage + back_emf, voltage);
+}
+
+template <class StateType, class InputType>
+  requires HasDimension<StateType> && HasDimension<InputType>
+class AffineEnsembleSim {
+  static constexpr int States = StateType::Dimension;
+  static constexpr int Inputs = InputType::Dimension;
+
+ public:
+  using StateArray = EnsembleArray<States>;
+  using InputArray = EnsembleArray<Inputs>;
+
+  explicit AffineEnsembleSim(int size)
+      : continuous_matrices_(size),
+        continuous_constants_(size),
+        discrete_system_(EnsembleArray<States * States>::Zero(size,
+                                                              States * States)),
+        discrete_input_(
+            EnsembleArray<States * Inputs>::Zero(size, States * Inputs)),
+        discrete_constant_(StateArray::Zero(size, States)),
+        stabilizing_input_(InputArray::Zero(size, Inputs)),
+        state_(StateArray::Zero(size, States)),
+        next_state_(StateArray::Zero(size, States)),
+        input_(InputArray::Zero(size, Inputs)),
+        // NOTE(hayden): Every member has its own matrices, so the cache holds
+        // a few dozen time steps for each
+        discretization_cache_(au::seconds(0.0),
+                              std::max<std::size_t>(256, size * 32)) {}
+
+  AffineEnsembleSim(const std::vector<Elevator> &elevators,
+                    LinearAcceleration gravity, Time time_step)
+      : AffineEnsembleSim(static_cast<int>(elevators.size())) {
+    for (int member = 0; member < Size(); ++member) {
+      const Elevator &elevator = elevators[member];
+      SetMember(member, elevator.ContinuousSystemMatrix<StateType>(),
+                elevator.ContinuousInputMatrix<StateType, InputType>(),
+                // TODO(hayden): This isn't compatible with other state types
+                StateVector<States>{
+                    0, gravity.in(au::meters / squared(au::second))},
+                time_step);
+    }
+  }
+
+  void SetMember(int member, const SystemMatrix<States> &continuous_system,
+                 const InputMatrix<States, Inputs> &continuous_input,
+                 const StateVector<States> &continuous_constant,
+                 Time time_step) {
+    continuous_matrices_[member] =
+        std::make_pair(continuous_system, continuous_input);
+    continuous_constants_[member] = continuous_constant;
+    DiscretizeMember(member, time_step);
+    time_step_ = time_step;
+  }
+
+  int Size() const { return static_cast<int>(state_.rows()); }
+
+  void Update(const InputArray &input) {
+    input_ = input;
+    Update();
+  }
+
+  // Advances every member by `time_step` using the stored inputs,
+  // rediscretizing only when it differs from the last time step
+  void Update(Time time_step) {
+    if (time_step != time_step_) {
+      for (int member = 0; member < Size(); ++member) {
+        DiscretizeMember(member, time_step);
+      }
+      time_step_ = time_step;
+    }
+    Update();
+  }
+
+  // Advances every member by one time step using the stored inputs
+  void Update() {
+    // xₖ₊₁ = Ad xₖ + Bd uₖ + cd, evaluated one state row at a time across all
+    // members
+    for (int row = 0; row < States; ++row) {
+      auto next = next_state_.col(row);
+      next = discrete_constant_.col(row);
+      for (int column = 0; column < States; ++column) {
+        next += discrete_system_.col(row * States + column) *
+                state_.col(column);
+      }
+      for (int column = 0; column < Inputs; ++column) {
+        next += discrete_input_.col(row * Inputs + column) * input_.col(column);
+      }
+    }
+    state_.swap(next_state_);
+  }
+
+  // NOTE(hayden): Assumes position is the first state, as in
+  // PositionVelocityState
+  void ClampPosition(const Eigen::Ref<const Eigen::ArrayXd> &min,
+                     const Eigen::Ref<const Eigen::ArrayXd> &max) {
+    state_.col(0) = state_.col(0).max(min).min(max);
+  }
+
+  const StateArray &State() const { return state_; }
+
+  StateArray &State() { return state_; }
+
+  StateType State(int member) const {
+    return StateType{
+        StateVector<States>(state_.row(member).transpose().matrix())};
+  }
+
+  void SetState(int member, StateType state) {
+    // TODO(hayden): Add `vector` type constraint for `StateType` or make
+    // `StateType` transparent
+    state_.row(member) = state.vector.transpose().array();
+  }
+
+  const InputArray &Input() const { return input_; }
+
+  InputArray &Input() { return input_; }
+
+  const InputArray &StabilizingInput() const { return stabilizing_input_; }
+
+ private:
+  void DiscretizeMember(int member, Time time_step) {
+    auto [Ad, Bd] =
+        discretization_cache_.Get(continuous_matrices_[member], time_step);
+    const StateVector<States> &continuous_constant =
+        continuous_constants_[member];
+    auto continuous_input_pseudoinverse =
+        PseudoInverse(continuous_matrices_[member].second);
+    StateVector<States> discrete_constant =
+        Bd * continuous_input_pseudoinverse * continuous_constant;
+    InputVector<Inputs> stabilizing_input =
+        -1 * continuous_input_pseudoinverse * continuous_constant;
+
+    for (int row = 0; row < States; ++row) {
+      for (int column = 0; column < States; ++column) {
+        discrete_system_(member, row * States + column) = Ad(row, column);
+      }
+      for (int column = 0; column < Inputs; ++column) {
+        discrete_input_(member, row * Inputs + column) = Bd(row, column);
+      }
+      discrete_constant_(member, row) = discrete_constant[row];
+    }
+    stabilizing_input_.row(member) = stabilizing_input.transpose().array();
+  }
+
+  std::vector<Matrices<States, Inputs>> continuous_matrices_;
+  std::vector<StateVector<States>> continuous_constants_;
+  EnsembleArray<States * States> discrete_system_;
+  EnsembleArray<States * Inputs> discrete_input_;
+  StateArray discrete_constant_;
+  InputArray stabilizing_input_;
+  StateArray state_;
+  StateArray next_state_;
+  InputArray input_;
+  Time time_step_;
+  DiscretizationCache<States, Inputs> discretization_cache_;
+};
+
+}  // namespace reefscape
@@ -15,33 +15,33 @@ class AffineSystemSim {
   static constexpr int Inputs = InputType::Dimension;
 
  public:
+  // NOTE(hayden): Measured time steps jitter by microseconds, so they are
+  // rounded to this before rediscretizing to keep the cache hit rate high
+  static constexpr Time kDefaultQuantum = (au::micro(au::seconds))(10.0);
+
   AffineSystemSim(SystemMatrix<States> continuous_system,
                   InputMatrix<States, Inputs> continuous_input,
-                  StateVector<States> continuous_constant, Time time_step)
+                  StateVector<States> continuous_constant, Time time_step,
+                  Time quantum = kDefaultQuantum)
       : continuous_system_(continuous_system),
         continuous_input_(continuous_input),
         continuous_constant_(continuous_constant),
         state_({}),
-        input_({}) {
-    auto continuous_matrices =
-        std::make_pair(continuous_system_, continuous_input_);
-    auto discretized_matrices = Discretize(continuous_matrices, time_step);
-    discrete_system_ = discretized_matrices.first;
-    discrete_input_ = discretized_matrices.second;
+        input_({}),
+        discretization_cache_(quantum) {
     continuous_input_pseudoinverse_ = PseudoInverse(continuous_input_);
-    discrete_constant_ << discrete_input_ * continuous_input_pseudoinverse_ *
-                              continuous_constant_;
+    Discretize(time_step);
   }
 
   AffineSystemSim(const Elevator &elevator, LinearAcceleration gravity,
-                  Time time_step)
+                  Time time_step, Time quantum = kDefaultQuantum)
       : AffineSystemSim(
             elevator.ContinuousSystemMatrix<StateType>(),
             elevator.ContinuousInputMatrix<StateType, InputType>(),
             // TODO(hayden): This isn't compatible with other state types
             StateVector<States>{0,
                                 gravity.in(au::meters / squared(au::second))},
-            time_step) {}
+            time_step, quantum) {}
 
   void Update(InputType input) {
     // TODO(hayden): Add `.vector` type constraint for `InputType` or make
@@ -51,6 +51,24 @@ class AffineSystemSim {
              discrete_constant_;
   }
 
+  // Advances by Quantize(time_step), rediscretizing only when that differs
+  // from the last time step
+  void Update(InputType input, Time time_step) {
+    if (Quantize(time_step) != time_step_) {
+      Discretize(time_step);
+    }
+    Update(input);
+  }
+
+  // Time step that Update(input, time_step) actually takes: the nearest
+  // multiple of the quantum, and at least one quantum
+  Time Quantize(Time time_step) const {
+    return discretization_cache_.Quantize(time_step);
+  }
+
+  // Time step that Update(input) takes
+  Time TimeStep() const { return time_step_; }
+
   StateType State() const { return StateType{state_}; }
 
   void SetState(StateType state) {
@@ -66,7 +84,21 @@ class AffineSystemSim {
     return {-1 * continuous_input_pseudoinverse_ * continuous_constant_};
   }
 
+  const DiscretizationCache<States, Inputs> &Cache() const {
+    return discretization_cache_;
+  }
+
  private:
+  void Discretize(Time time_step) {
+    auto discretized_matrices = discretization_cache_.Get(
+        std::make_pair(continuous_system_, continuous_input_), time_step);
+    discrete_system_ = discretized_matrices.first;
+    discrete_input_ = discretized_matrices.second;
+    discrete_constant_ << discrete_input_ * continuous_input_pseudoinverse_ *
+                              continuous_constant_;
+    time_step_ = discretization_cache_.Quantize(time_step);
+  }
+
   SystemMatrix<States> continuous_system_;
   InputMatrix<States, Inputs> continuous_input_;
   InputLeftPseudoInverseMatrix<States, Inputs> continuous_input_pseudoinverse_;
@@ -76,6 +108,8 @@ class AffineSystemSim {
   StateVector<States> discrete_constant_;
   StateVector<States> state_;
   InputVector<Inputs> input_;
+  Time time_step_;
+  DiscretizationCache<States, Inputs> discretization_cache_;
 };
 
 }  // namespace reefscape
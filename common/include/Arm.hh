@@ -11,14 +11,20 @@ struct Arm {
   GearRatio gear_ratio;
   Displacement length;
   MomentOfInertia moment_of_inertia;
+  Mass mass;
+  // NOTE(hayden): Distance from the pivot to the center of mass
+  Displacement center_of_mass;
   Current max_current;
   Motor motor;
 
   Arm(GearRatio gear_ratio, Displacement length,
-      MomentOfInertia moment_of_inertia, Current max_current, Motor motor)
+      MomentOfInertia moment_of_inertia, Mass mass,
+      Displacement center_of_mass, Current max_current, Motor motor)
       : gear_ratio(gear_ratio),
         length(length),
         moment_of_inertia(moment_of_inertia),
+        mass(mass),
+        center_of_mass(center_of_mass),
         max_current(max_current),
         motor(motor) {};
 
@@ -32,6 +38,10 @@ struct Arm {
                                    Voltage voltage) const;
 
   quantities::Torque Torque(AngularVelocity velocity, Voltage voltage) const;
+
+  // NOTE(hayden): The angle is measured from horizontal
+  AngularAcceleration GravityAcceleration(Angle angle,
+                                          LinearAcceleration gravity) const;
 };
 
 }  // namespace reefscape
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <stop_token>
+#include <thread>
+
+#include "SPSCQueue.hh"
+#include "pubsub.hh"
+#include "sample.hh"
+
+namespace reefscape {
+
+// Publishes from a dedicated I/O thread so that NT never stalls the loop.
+// Publish only writes the shared-memory ring (if any) and pushes onto a
+// bounded lock-free queue, so its cost doesn't depend on the network. The
+// I/O thread sends whatever has queued up and flushes once per batch.
+class AsyncPublisher {
+ public:
+  explicit AsyncPublisher(Publisher publisher,
+                          std::size_t capacity = std::size_t{1} << 12);
+
+  AsyncPublisher(const AsyncPublisher &) = delete;
+  AsyncPublisher &operator=(const AsyncPublisher &) = delete;
+
+  // Sends every queued sample before returning
+  ~AsyncPublisher();
+
+  // Never blocks; drops the sample from NT if the I/O thread has fallen a
+  // full queue behind
+  void Publish(const Sample &sample);
+
+  // Samples dropped because the queue was full
+  std::uint64_t Dropped() const {
+    return dropped_.load(std::memory_order_relaxed);
+  }
+
+  // Samples handed to NT
+  std::uint64_t Sent() const { return sent_.load(std::memory_order_relaxed); }
+
+  std::uint64_t Flushes() const {
+    return flushes_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  void Run(std::stop_token stop_token);
+
+  // Sends every queued sample and flushes, returning how many were sent
+  std::size_t Drain();
+
+  Publisher publisher_;
+  SPSCQueue<Sample> queue_;
+  std::atomic<std::uint64_t> dropped_ = 0;
+  std::atomic<std::uint64_t> sent_ = 0;
+  std::atomic<std::uint64_t> flushes_ = 0;
+  std::jthread thread_;
+};
+
+}  // namespace reefscape
@@ -1,6 +1,12 @@
 #pragma once
 
 #include <Eigen/Core>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <unordered_map>
 #include <unsupported/Eigen/MatrixFunctions>
 #include <utility>
 
@@ -55,6 +61,98 @@ Matrices<States, Inputs> Discretize(Matrices<States, Inputs> &AcBc,
   return std::make_pair(Ad, Bd);
 }
 
+// Memoizes Discretize() by (Ac, Bc, sample period) so loops with variable or
+// multi-rate time steps only pay for each matrix exponential once
+template <int States, int Inputs>
+class DiscretizationCache {
+ public:
+  // NOTE(hayden): A non-zero quantum rounds sample periods to a multiple of it
+  // before lookup, trading exactness for hit rate on jittery loops
+  explicit DiscretizationCache(
+      quantities::Time quantum = au::seconds(0.0), std::size_t capacity = 256)
+      : quantum_(quantum), capacity_(capacity) {}
+
+  Matrices<States, Inputs> Get(const Matrices<States, Inputs> &AcBc,
+                               quantities::Time sample_period) {
+    Key key{AcBc, Quantize(sample_period).in(au::seconds)};
+
+    if (auto it = index_.find(key); it != index_.end()) {
+      ++hits_;
+      entries_.splice(entries_.begin(), entries_, it->second);
+      return it->second->second;
+    }
+
+    ++misses_;
+    // NOTE(hayden): Unbounded sample periods (no quantum) would otherwise grow
+    // the cache forever, so the least recently used entry makes room while
+    // the periods a loop keeps hitting stay cached
+    if (entries_.size() >= capacity_) {
+      index_.erase(entries_.back().first);
+      entries_.pop_back();
+    }
+    Matrices<States, Inputs> AcBc_copy = AcBc;
+    auto AdBd = Discretize(AcBc_copy, au::seconds(key.sample_period));
+    entries_.emplace_front(key, AdBd);
+    index_.emplace(std::move(key), entries_.begin());
+    return AdBd;
+  }
+
+  // NOTE(hayden): A period under half a quantum would round to zero, which
+  // freezes the state while time advances, so none rounds below one quantum
+  quantities::Time Quantize(quantities::Time sample_period) const {
+    if (quantum_ <= au::seconds(0.0)) {
+      return sample_period;
+    }
+    return quantum_ * std::max(1.0, std::round(sample_period.in(au::seconds) /
+                                               quantum_.in(au::seconds)));
+  }
+
+  std::size_t Hits() const { return hits_; }
+
+  std::size_t Misses() const { return misses_; }
+
+  std::size_t Size() const { return entries_.size(); }
+
+ private:
+  struct Key {
+    Matrices<States, Inputs> AcBc;
+    double sample_period;
+
+    bool operator==(const Key &other) const {
+      return sample_period == other.sample_period &&
+             AcBc.first == other.AcBc.first &&
+             AcBc.second == other.AcBc.second;
+    }
+  };
+
+  struct KeyHash {
+    std::size_t operator()(const Key &key) const {
+      std::size_t seed = std::hash<double>{}(key.sample_period);
+      auto combine = [&seed](double value) {
+        seed ^= std::hash<double>{}(value) + 0x9e3779b9 + (seed << 6) +
+                (seed >> 2);
+      };
+      for (double value : key.AcBc.first.reshaped()) {
+        combine(value);
+      }
+      for (double value : key.AcBc.second.reshaped()) {
+        combine(value);
+      }
+      return seed;
+    }
+  };
+
+  using Entries = std::list<std::pair<Key, Matrices<States, Inputs>>>;
+
+  quantities::Time quantum_;
+  std::size_t capacity_;
+  // Most recently used first
+  Entries entries_;
+  std::unordered_map<Key, typename Entries::iterator, KeyHash> index_;
+  std::size_t hits_ = 0;
+  std::size_t misses_ = 0;
+};
+
 template <int States, int Inputs>
 InputLeftPseudoInverseMatrix<States, Inputs> PseudoInverse(
     const InputMatrix<States, Inputs> &Bc) {
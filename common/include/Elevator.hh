@@ -17,8 +17,8 @@ struct Elevator {
   Displacement max_travel;
   Motor motor;
 
-  Elevator(GearRatio gear_ratio, Displacement drum_radius, Mass mass,
-           Current max_current, Displacement max_travel, Motor motor)
+  constexpr Elevator(GearRatio gear_ratio, Displacement drum_radius, Mass mass,
+                     Current max_current, Displacement max_travel, Motor motor)
       : gear_ratio(gear_ratio),
         drum_radius(drum_radius),
         mass(mass),
@@ -26,9 +26,17 @@ struct Elevator {
         max_travel(max_travel),
         motor(motor) {};
 
-  LinearVelocityCoefficient VelocityCoefficient() const;
-
-  LinearVoltageCoefficient VoltageCoefficient() const;
+  constexpr LinearVelocityCoefficient VelocityCoefficient() const {
+    return -1 *
+           (gear_ratio * gear_ratio * motor.torque_constant_ * au::radians(1)) /
+           (motor.resistance_ * drum_radius * drum_radius * mass *
+            motor.angular_velocity_constant_);
+  }
+
+  constexpr LinearVoltageCoefficient VoltageCoefficient() const {
+    return (gear_ratio * motor.torque_constant_) /
+           (motor.resistance_ * mass * drum_radius);
+  }
 
   AngularVelocity MotorVelocity(LinearVelocity velocity) const;
 
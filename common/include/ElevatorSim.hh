@@ -0,0 +1,152 @@
+#pragma once
+
+#include "Elevator.hh"
+#include "input.hh"
+#include "state.hh"
+#include "units.hh"
+
+namespace reefscape {
+
+using namespace quantities;
+
+namespace closed_form {
+
+// NOTE(hayden): std::exp is not constexpr until C++26
+constexpr double Exp(double x) {
+  // eˣ = (e^(x/2ⁿ))^(2ⁿ), with the Taylor series evaluated for |x/2ⁿ| ≤ 1/2
+  int squarings = 0;
+  while (x > 0.5 || x < -0.5) {
+    x /= 2;
+    ++squarings;
+  }
+
+  double term = 1;
+  double sum = 1;
+  for (int n = 1; n < 20; ++n) {
+    term *= x / n;
+    sum += term;
+  }
+
+  while (squarings-- > 0) {
+    sum *= sum;
+  }
+  return sum;
+}
+
+// φ₁(x) = (eˣ - 1) / x = Σ xⁿ / (n + 1)!
+constexpr double Phi1(double x) {
+  if (x > 1 || x < -1) {
+    return (Exp(x) - 1) / x;
+  }
+
+  double term = 1;
+  double sum = 1;
+  for (int n = 1; n < 25; ++n) {
+    term *= x / (n + 1);
+    sum += term;
+  }
+  return sum;
+}
+
+// φ₂(x) = (eˣ - 1 - x) / x² = Σ xⁿ / (n + 2)!
+constexpr double Phi2(double x) {
+  if (x > 1 || x < -1) {
+    return (Exp(x) - 1 - x) / (x * x);
+  }
+
+  double term = 0.5;
+  double sum = 0.5;
+  for (int n = 1; n < 25; ++n) {
+    term *= x / (n + 2);
+    sum += term;
+  }
+  return sum;
+}
+
+}  // namespace closed_form
+
+// Discrete form of the PositionVelocityState elevator model
+//
+// Ac = ⎡ 0 1 ⎤  Bc = ⎡ 0 ⎤  c = ⎡ 0 ⎤
+//      ⎣ 0 a ⎦       ⎣ b ⎦      ⎣ g ⎦
+//
+// Ad = ⎡ 1 Tφ₁(aT) ⎤  Bd = ⎡ bT²φ₂(aT) ⎤  cd = Bd·g/b
+//      ⎣ 0 eᵃᵀ     ⎦       ⎣ bTφ₁(aT)  ⎦
+struct ElevatorDiscretization {
+  double system_position_velocity;
+  double system_velocity_velocity;
+  double input_position;
+  double input_velocity;
+  double constant_position;
+  double constant_velocity;
+  double stabilizing_voltage;
+
+  constexpr ElevatorDiscretization(const Elevator &elevator,
+                                   LinearAcceleration gravity, Time time_step) {
+    double a = elevator.VelocityCoefficient().in(
+        (au::meters / squared(au::second)) / (au::meters / au::second));
+    double b = elevator.VoltageCoefficient().in(
+        (au::meters / squared(au::second)) / au::volt);
+    double g = gravity.in(au::meters / squared(au::second));
+    double T = time_step.in(au::seconds);
+
+    double phi1 = closed_form::Phi1(a * T);
+    double phi2 = closed_form::Phi2(a * T);
+
+    system_position_velocity = T * phi1;
+    system_velocity_velocity = 1 + a * T * phi1;
+    input_position = b * T * T * phi2;
+    input_velocity = b * T * phi1;
+    constant_position = g * T * T * phi2;
+    constant_velocity = g * T * phi1;
+    stabilizing_voltage = -g / b;
+  }
+};
+
+// AffineSystemSim specialized for PositionVelocityState elevators, stepping
+// with the closed-form discretization in scalar code
+class ElevatorSim {
+ public:
+  constexpr ElevatorSim(const ElevatorDiscretization &discretization)
+      : discretization_(discretization) {}
+
+  constexpr ElevatorSim(const Elevator &elevator, LinearAcceleration gravity,
+                        Time time_step)
+      : ElevatorSim(ElevatorDiscretization{elevator, gravity, time_step}) {}
+
+  void Update(VoltageInput input) {
+    voltage_ = input.vector[0];
+    const ElevatorDiscretization &d = discretization_;
+    position_ += d.system_position_velocity * velocity_ +
+                 d.input_position * voltage_ + d.constant_position;
+    velocity_ = d.system_velocity_velocity * velocity_ +
+                d.input_velocity * voltage_ + d.constant_velocity;
+  }
+
+  PositionVelocityState State() const {
+    return {au::meters(position_), (au::meters / au::second)(velocity_)};
+  }
+
+  void SetState(PositionVelocityState state) {
+    position_ = state.vector[0];
+    velocity_ = state.vector[1];
+  }
+
+  VoltageInput Input() const { return {au::volts(voltage_)}; }
+
+  VoltageInput StabilizingInput() const {
+    return {au::volts(discretization_.stabilizing_voltage)};
+  }
+
+  constexpr const ElevatorDiscretization &Discretization() const {
+    return discretization_;
+  }
+
+ private:
+  ElevatorDiscretization discretization_;
+  double position_ = 0;
+  double velocity_ = 0;
+  double voltage_ = 0;
+};
+
+}  // namespace reefscape
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <Eigen/LU>
+#include <algorithm>
+#include <array>
+#include <span>
+#include <vector>
+
+#include "Eigen.hh"
+#include "Elevator.hh"
+#include "input.hh"
+#include "state.hh"
+#include "units.hh"
+
+namespace reefscape {
+
+template <int States, int Inputs>
+using GainMatrix = Eigen::Matrix<double, Inputs, States>;
+
+template <int Inputs>
+using InputCostMatrix = Eigen::Matrix<double, Inputs, Inputs>;
+
+// Bryson's rule: penalize each state or input by the inverse square of its
+// largest acceptable value
+template <int N>
+Eigen::Matrix<double, N, N> CostMatrix(const std::array<double, N> &maximums) {
+  Eigen::Matrix<double, N, N> result = Eigen::Matrix<double, N, N>::Zero();
+  for (int i = 0; i < N; ++i) {
+    result(i, i) = 1.0 / (maximums[i] * maximums[i]);
+  }
+  return result;
+}
+
+// Solves the discrete algebraic Riccati equation
+//
+// P = AᵀPA - AᵀPB(R + BᵀPB)⁻¹BᵀPA + Q
+//
+// with the structure-preserving doubling algorithm, which converges
+// quadratically for stabilizable (A, B) and detectable (A, Q)
+template <int States, int Inputs>
+SystemMatrix<States> DARE(const SystemMatrix<States> &A,
+                          const InputMatrix<States, Inputs> &B,
+                          const SystemMatrix<States> &Q,
+                          const InputCostMatrix<Inputs> &R,
+                          int max_iterations = 100, double tolerance = 1e-10) {
+  // A₀ = A, G₀ = BR⁻¹Bᵀ, H₀ = Q
+  SystemMatrix<States> Ak = A;
+  SystemMatrix<States> G = B * R.inverse() * B.transpose();
+  SystemMatrix<States> H = Q;
+
+  for (int i = 0; i < max_iterations; ++i) {
+    // Wₖ = I + GₖHₖ
+    auto W = (SystemMatrix<States>::Identity() + G * H).partialPivLu();
+    SystemMatrix<States> V1 = W.solve(Ak);
+    SystemMatrix<States> V2 = W.solve(G);
+
+    // Hₖ₊₁ = Hₖ + AₖᵀHₖWₖ⁻¹Aₖ, Gₖ₊₁ = Gₖ + AₖWₖ⁻¹GₖAₖᵀ, Aₖ₊₁ = AₖWₖ⁻¹Aₖ
+    SystemMatrix<States> next_H = H + V1.transpose() * H * Ak;
+    G += Ak * V2 * Ak.transpose();
+    Ak = Ak * V1;
+
+    bool converged = (next_H - H).norm() <= tolerance * next_H.norm();
+    H = next_H;
+    if (converged) {
+      break;
+    }
+  }
+
+  return H;
+}
+
+// Optimal discrete state feedback u = K(r - x) for the discretized system
+template <int States, int Inputs>
+GainMatrix<States, Inputs> LQR(const Matrices<States, Inputs> &AdBd,
+                               const SystemMatrix<States> &Q,
+                               const InputCostMatrix<Inputs> &R) {
+  const auto &[A, B] = AdBd;
+  SystemMatrix<States> P = DARE<States, Inputs>(A, B, Q, R);
+  // K = (R + BᵀPB)⁻¹BᵀPA
+  return (R + B.transpose() * P * B)
+      .partialPivLu()
+      .solve(B.transpose() * P * A);
+}
+
+// Gains tabulated over a uniform grid of masses for each of a set of
+// configurations (e.g. gearings), so the loop only interpolates between
+// precomputed gains instead of solving a Riccati equation every tick
+template <int States, int Inputs>
+class GainSchedule {
+ public:
+  GainSchedule(int configurations, quantities::Mass min_mass,
+               quantities::Mass max_mass, int masses)
+      : configurations_(configurations),
+        masses_(std::max(masses, 2)),
+        min_mass_(min_mass),
+        mass_step_((max_mass - min_mass) / (masses_ - 1)),
+        gains_(configurations_ * masses_) {}
+
+  int Configurations() const { return configurations_; }
+
+  int Masses() const { return masses_; }
+
+  quantities::Mass MassAt(int index) const {
+    return min_mass_ + mass_step_ * index;
+  }
+
+  void Set(int configuration, int mass_index,
+           const GainMatrix<States, Inputs> &gain) {
+    gains_[configuration * masses_ + mass_index] = gain;
+  }
+
+  // Linearly interpolated gain, clamped to the tabulated mass range
+  GainMatrix<States, Inputs> Gain(int configuration,
+                                  quantities::Mass mass) const {
+    const auto *row = &gains_[configuration * masses_];
+    // NOTE(hayden): A schedule for a single mass has every gain at that mass
+    if (mass_step_ == au::kilo(au::grams)(0.0)) {
+      return row[0];
+    }
+
+    // NOTE(hayden): std::max and std::min take the lower bound for NaN, unlike
+    // std::clamp, so the index is always in range
+    double position = std::min(
+        std::max(0.0, (mass - min_mass_).in(units::MassUnit{}) /
+                          mass_step_.in(units::MassUnit{})),
+        static_cast<double>(masses_ - 1));
+    int index = std::min(static_cast<int>(position), masses_ - 2);
+    double fraction = position - index;
+
+    return (1 - fraction) * row[index] + fraction * row[index + 1];
+  }
+
+ private:
+  int configurations_;
+  int masses_;
+  quantities::Mass min_mass_;
+  quantities::Mass mass_step_;
+  std::vector<GainMatrix<States, Inputs>> gains_;
+};
+
+using ElevatorGainSchedule =
+    GainSchedule<PositionVelocityState::Dimension, VoltageInput::Dimension>;
+
+// Tabulates LQR gains for `elevator` with each gear ratio and payload masses
+// from `min_mass` to `max_mass`
+ElevatorGainSchedule MakeElevatorGainSchedule(
+    const Elevator &elevator, std::span<const GearRatio> gear_ratios,
+    Mass min_mass, Mass max_mass, int masses, Time time_step,
+    const SystemMatrix<PositionVelocityState::Dimension> &Q,
+    const InputCostMatrix<VoltageInput::Dimension> &R);
+
+}  // namespace reefscape
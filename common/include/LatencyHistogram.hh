@@ -0,0 +1,135 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "ntcore_c.h"
+#include "units.hh"
+
+namespace reefscape {
+
+// Log-linear histogram of durations in nanoseconds, in the style of
+// HdrHistogram: every power of two is split into 16 buckets, so any recorded
+// value is known to within 1/16. Recording is a relaxed atomic increment, so
+// another thread can read percentiles while the loop records.
+class LatencyHistogram {
+ public:
+  // Values at or beyond 2³⁶ ns (about 69 s) are recorded in the last bucket
+  static constexpr int kSubBucketBits = 4;
+  static constexpr int kSubBuckets = 1 << kSubBucketBits;
+  static constexpr int kMaxBits = 36;
+  static constexpr int kBuckets = (kMaxBits - kSubBucketBits + 1) * kSubBuckets;
+
+  void Record(std::int64_t nanoseconds) {
+    constexpr std::int64_t kLargest = (std::int64_t{1} << kMaxBits) - 1;
+    auto value = static_cast<std::uint64_t>(
+        std::clamp<std::int64_t>(nanoseconds, 0, kLargest));
+    buckets_[Index(value)].fetch_add(1, std::memory_order_relaxed);
+
+    std::uint64_t max = max_.load(std::memory_order_relaxed);
+    while (value > max &&
+           !max_.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+    }
+  }
+
+  std::uint64_t Count() const;
+
+  std::uint64_t Max() const { return max_.load(std::memory_order_relaxed); }
+
+  // Upper bound of the bucket holding the `quantile` (0 to 1) value, in
+  // nanoseconds
+  std::uint64_t Quantile(double quantile) const;
+
+ private:
+  static constexpr int Index(std::uint64_t value) {
+    if (value < kSubBuckets) {
+      return static_cast<int>(value);
+    }
+    // NOTE(hayden): Shift so that the top kSubBucketBits + 1 bits remain; the
+    // leading one selects the power of two and the rest the sub-bucket
+    int shift = std::bit_width(value) - kSubBucketBits - 1;
+    return (shift + 1) * kSubBuckets +
+           static_cast<int>((value >> shift) - kSubBuckets);
+  }
+
+  static constexpr std::uint64_t UpperBound(int index) {
+    if (index < kSubBuckets) {
+      return index;
+    }
+    int shift = index / kSubBuckets - 1;
+    std::uint64_t mantissa = index % kSubBuckets + kSubBuckets;
+    return ((mantissa + 1) << shift) - 1;
+  }
+
+  std::array<std::atomic<std::uint64_t>, kBuckets> buckets_{};
+  std::atomic<std::uint64_t> max_ = 0;
+};
+
+// Prints the count and common quantiles in microseconds
+std::ostream &operator<<(std::ostream &stream,
+                         const LatencyHistogram &histogram);
+
+// Records the time from construction to destruction, or nothing if the
+// histogram is null
+class ScopedTimer {
+ public:
+  explicit ScopedTimer(LatencyHistogram *histogram) : histogram_(histogram) {
+    if (histogram_ != nullptr) {
+      start_ = Clock::now();
+    }
+  }
+
+  ScopedTimer(const ScopedTimer &) = delete;
+  ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+  ~ScopedTimer() {
+    if (histogram_ != nullptr) {
+      histogram_->Record(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() -
+                                                               start_)
+              .count());
+    }
+  }
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  LatencyHistogram *histogram_;
+  Clock::time_point start_;
+};
+
+struct NamedHistogram {
+  std::string name;
+  const LatencyHistogram *histogram;
+};
+
+// Periodically publishes each histogram from its own thread as a double array
+// topic `prefix`/`name` of [count, p50, p90, p99, p99.9, max], with the
+// quantiles in microseconds
+class LatencyPublisher {
+ public:
+  LatencyPublisher(NT_Inst instance, std::string_view prefix,
+                   std::vector<NamedHistogram> histograms,
+                   quantities::Time period = au::seconds(1));
+
+ private:
+  void Run(std::stop_token stop_token);
+
+  std::vector<NamedHistogram> histograms_;
+  std::vector<NT_Publisher> publishers_;
+  std::chrono::nanoseconds period_;
+  std::jthread thread_;
+};
+
+}  // namespace reefscape
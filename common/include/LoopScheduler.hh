@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+
+#include "units.hh"
+
+namespace reefscape {
+
+struct LoopSchedulerOptions {
+  // Run under SCHED_FIFO at `priority`, which usually requires CAP_SYS_NICE
+  bool realtime = false;
+  int priority = 80;
+  // Pin the calling thread to this CPU, if not negative
+  int cpu = -1;
+  // Lock every current and future page into memory so the loop never faults
+  bool lock_memory = false;
+};
+
+struct LoopStatistics {
+  std::int64_t cycles = 0;
+  // Cycles whose work ran past the next deadline
+  std::int64_t overruns = 0;
+  // Times the schedule was abandoned after falling too far behind
+  std::int64_t resyncs = 0;
+  // Wakeup lateness past each deadline, in nanoseconds
+  double mean_lateness = 0;
+  std::int64_t max_lateness = 0;
+  // Extremes of the measured period between wakeups, in nanoseconds
+  std::int64_t min_period = 0;
+  std::int64_t max_period = 0;
+};
+
+std::ostream &operator<<(std::ostream &stream,
+                         const LoopStatistics &statistics);
+
+// Paces a loop to absolute deadlines on CLOCK_MONOTONIC, so that time spent
+// working and oversleeping doesn't accumulate as drift
+class LoopScheduler {
+ public:
+  // Applies `options` to the calling thread, warning about any that can't be
+  // applied
+  LoopScheduler(quantities::Time period, const LoopSchedulerOptions &options);
+
+  // Sleeps until the next deadline. A cycle that overran returns immediately,
+  // so the loop catches up instead of losing time, unless it has fallen more
+  // than kMaxBehind periods behind. Returns the measured time since the
+  // previous wakeup, or the period on the first call.
+  quantities::Time Wait();
+
+  const LoopStatistics &Statistics() const { return statistics_; }
+
+ private:
+  static constexpr std::int64_t kMaxBehind = 100;
+
+  std::int64_t period_;
+  std::int64_t deadline_;
+  std::int64_t last_wakeup_ = -1;
+  double total_lateness_ = 0;
+  LoopStatistics statistics_;
+};
+
+}  // namespace reefscape
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "MotorSystem.hh"
+#include "au/math.hh"
+#include "units.hh"
+
+namespace reefscape {
+
+// Derived constants of a MotorSystem, computed once so that LimitVoltage and
+// Current in the loop reduce to a few multiplies on raw doubles. Members keep
+// their au types, so units are still checked at compile time.
+template <typename NativeUnit>
+struct MotorSystemConstants {
+  using VelocityType = au::QuantityD<units::Velocity<NativeUnit>>;
+  using BackEMFCoefficient = au::QuantityD<decltype(
+      units::VoltageUnit{} / units::Velocity<NativeUnit>{})>;
+
+  quantities::Voltage nominal_voltage;
+  // Back-EMF voltage per unit of system velocity
+  BackEMFCoefficient back_emf_coefficient;
+  quantities::Resistance resistance;
+  // Voltage that drives max current through a stalled motor
+  quantities::Voltage current_limit_voltage;
+
+  template <typename System>
+    requires MotorSystem<System, NativeUnit>
+  explicit MotorSystemConstants(const System& system)
+      : nominal_voltage(system.motor.nominal_voltage_),
+        resistance(system.motor.resistance_),
+        current_limit_voltage(system.max_current * system.motor.resistance_) {
+    auto unit_velocity = au::make_quantity<units::Velocity<NativeUnit>>(1.0);
+    back_emf_coefficient = system.MotorVelocity(unit_velocity) /
+                           system.motor.angular_velocity_constant_ /
+                           unit_velocity;
+  }
+
+  quantities::Voltage BackEMF(VelocityType velocity) const {
+    return back_emf_coefficient * velocity;
+  }
+};
+
+// Equivalent to Current(system, velocity, voltage)
+template <typename NativeUnit>
+quantities::Current Current(
+    const MotorSystemConstants<NativeUnit>& constants,
+    typename MotorSystemConstants<NativeUnit>::VelocityType velocity,
+    quantities::Voltage voltage) {
+  return (voltage - constants.BackEMF(velocity)) / constants.resistance;
+}
+
+// Equivalent to LimitVoltage(system, velocity, voltage)
+template <typename NativeUnit>
+quantities::Voltage LimitVoltage(
+    const MotorSystemConstants<NativeUnit>& constants,
+    typename MotorSystemConstants<NativeUnit>::VelocityType velocity,
+    quantities::Voltage voltage) {
+  voltage = au::clamp(voltage, -constants.nominal_voltage,
+                      constants.nominal_voltage);
+
+  // NOTE(hayden): Current exceeds the limit when the voltage across the
+  // winding resistance (applied voltage minus back-EMF) exceeds I_max·R
+  auto back_emf = constants.BackEMF(velocity);
+  if (voltage - back_emf > constants.current_limit_voltage) {
+    voltage = constants.current_limit_voltage + back_emf;
+  }
+  return voltage;
+}
+
+}  // namespace reefscape
@@ -0,0 +1,280 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include "Arm.hh"
+#include "Eigen.hh"
+#include "MotorSystem.hh"
+#include "units.hh"
+
+namespace reefscape {
+
+using namespace quantities;
+
+enum class Integrator { kRK4, kDormandPrince };
+
+// External acceleration in NativeUnit per second squared as a function of
+// position and velocity
+struct NoDisturbance {
+  double operator()(double, double) const { return 0; }
+};
+
+// Gravity on an arm, evaluated without unit conversions in the integrator
+struct ArmGravity {
+  // m·g·r / I in radians per second squared
+  double coefficient;
+
+  ArmGravity(const Arm &arm, LinearAcceleration gravity)
+      : coefficient(arm.GravityAcceleration(au::radians(0), gravity)
+                        .in(au::radians / squared(au::second))) {}
+
+  double operator()(double angle, double) const {
+    return coefficient * std::cos(angle);
+  }
+};
+
+// Simulates a motor system with a nonlinear disturbance, such as gravity on an
+// arm, by integrating
+//
+// ẋ = v, v̇ = (velocity_coefficient)·v + (voltage_coefficient)·u + d(x, v)
+//
+// with the voltage held constant over each update
+template <typename System, typename NativeUnit,
+          typename Disturbance = NoDisturbance>
+  requires MotorSystem<System, NativeUnit>
+class NonlinearSystemSim {
+  using Vector = StateVector<2>;
+
+ public:
+  NonlinearSystemSim(const System &system, Disturbance disturbance = {},
+                     Integrator integrator = Integrator::kRK4)
+      : velocity_coefficient_(system.VelocityCoefficient().in(
+            units::Acceleration<NativeUnit>{} / units::Velocity<NativeUnit>{})),
+        voltage_coefficient_(system.VoltageCoefficient().in(
+            units::Acceleration<NativeUnit>{} / units::VoltageUnit{})),
+        disturbance_(disturbance),
+        integrator_(integrator),
+        state_(Vector::Zero()) {}
+
+  // Advances by `time_step`; Dormand-Prince takes as many internal steps as
+  // its error tolerances require, carrying its step size across updates
+  void Update(Voltage voltage, Time time_step) {
+    voltage_ = voltage.in(au::volts);
+    double duration = time_step.in(au::seconds);
+
+    if (integrator_ == Integrator::kRK4) {
+      state_ = RK4Step(state_, duration);
+      ++accepted_steps_;
+      return;
+    }
+
+    double elapsed = 0;
+    Vector k1 = Derivative(state_);
+    while (elapsed < duration) {
+      double step = std::min({step_size_, max_step_size_, duration - elapsed});
+      Vector error;
+      Vector k7;
+      Vector next = DormandPrinceStep(state_, k1, step, error, k7);
+
+      double error_norm = 0;
+      for (int i = 0; i < 2; ++i) {
+        double magnitude = std::max(std::abs(state_[i]), std::abs(next[i]));
+        double scale = absolute_tolerance_ + relative_tolerance_ * magnitude;
+        error_norm = std::max(error_norm, std::abs(error[i]) / scale);
+      }
+
+      // NOTE(hayden): Steps shorter than the minimum are accepted regardless
+      // of error so a stiff input can't stall the simulation
+      if (error_norm <= 1 || step <= min_step_size_) {
+        state_ = next;
+        k1 = k7;
+        elapsed += step;
+        ++accepted_steps_;
+      } else {
+        ++rejected_steps_;
+      }
+
+      double factor =
+          error_norm == 0 ? 5 : 0.9 * std::pow(error_norm, -1.0 / 5);
+      step_size_ = std::max(step * std::clamp(factor, 0.2, 5.0),
+                            min_step_size_);
+    }
+  }
+
+  au::QuantityD<NativeUnit> Position() const {
+    return au::make_quantity<NativeUnit>(state_[0]);
+  }
+
+  au::QuantityD<units::Velocity<NativeUnit>> Velocity() const {
+    return au::make_quantity<units::Velocity<NativeUnit>>(state_[1]);
+  }
+
+  void SetState(au::QuantityD<NativeUnit> position,
+                au::QuantityD<units::Velocity<NativeUnit>> velocity) {
+    state_[0] = position.in(NativeUnit{});
+    state_[1] = velocity.in(units::Velocity<NativeUnit>{});
+  }
+
+  void SetIntegrator(Integrator integrator) { integrator_ = integrator; }
+
+  void SetTolerances(double relative, double absolute) {
+    relative_tolerance_ = relative;
+    absolute_tolerance_ = absolute;
+  }
+
+  void SetStepSizeLimits(Time min, Time max) {
+    min_step_size_ = min.in(au::seconds);
+    max_step_size_ = max.in(au::seconds);
+  }
+
+  int AcceptedSteps() const { return accepted_steps_; }
+
+  int RejectedSteps() const { return rejected_steps_; }
+
+ private:
+  Vector Derivative(const Vector &state) const {
+    return {state[1], velocity_coefficient_ * state[1] +
+                          voltage_coefficient_ * voltage_ +
+                          disturbance_(state[0], state[1])};
+  }
+
+  Vector RK4Step(const Vector &state, double h) const {
+    Vector k1 = Derivative(state);
+    Vector k2 = Derivative(state + h / 2 * k1);
+    Vector k3 = Derivative(state + h / 2 * k2);
+    Vector k4 = Derivative(state + h * k3);
+    return state + h / 6 * (k1 + 2 * k2 + 2 * k3 + k4);
+  }
+
+  // Fifth order Dormand-Prince step with an embedded fourth order error
+  // estimate; k7 is the derivative at the new state (first same as last)
+  Vector DormandPrinceStep(const Vector &state, const Vector &k1, double h,
+                           Vector &error, Vector &k7) const {
+    Vector k2 = Derivative(state + h * (1.0 / 5 * k1));
+    Vector k3 = Derivative(state + h * (3.0 / 40 * k1 + 9.0 / 40 * k2));
+    Vector k4 = Derivative(
+        state + h * (44.0 / 45 * k1 - 56.0 / 15 * k2 + 32.0 / 9 * k3));
+    Vector k5 = Derivative(state + h * (19372.0 / 6561 * k1 -
+                                        25360.0 / 2187 * k2 +
+                                        64448.0 / 6561 * k3 -
+                                        212.0 / 729 * k4));
+    Vector k6 = Derivative(state + h * (9017.0 / 3168 * k1 -
+                                        355.0 / 33 * k2 +
+                                        46732.0 / 5247 * k3 +
+                                        49.0 / 176 * k4 -
+                                        5103.0 / 18656 * k5));
+    Vector next = state + h * (35.0 / 384 * k1 + 500.0 / 1113 * k3 +
+                               125.0 / 192 * k4 - 2187.0 / 6784 * k5 +
+                               11.0 / 84 * k6);
+    k7 = Derivative(next);
+    error = h * (71.0 / 57600 * k1 - 71.0 / 16695 * k3 + 71.0 / 1920 * k4 -
+                 17253.0 / 339200 * k5 + 22.0 / 525 * k6 - 1.0 / 40 * k7);
+    return next;
+  }
+
+  double velocity_coefficient_;
+  double voltage_coefficient_;
+  Disturbance disturbance_;
+  Integrator integrator_;
+  Vector state_;
+  double voltage_ = 0;
+
+  double relative_tolerance_ = 1e-6;
+  double absolute_tolerance_ = 1e-9;
+  double min_step_size_ = 1e-6;
+  double max_step_size_ = 1.0;
+  double step_size_ = 1e-3;
+  int accepted_steps_ = 0;
+  int rejected_steps_ = 0;
+};
+
+// Gravity on every arm of an ensemble, with per-member m·g·r / I
+struct ArmEnsembleGravity {
+  Eigen::ArrayXd coefficient;
+
+  void operator()(const Eigen::ArrayXd &angle, const Eigen::ArrayXd &,
+                  Eigen::ArrayXd &acceleration) const {
+    acceleration = coefficient * angle.cos();
+  }
+};
+
+// RK4 over many members of the same kind of system with per-member
+// coefficients, in struct-of-arrays layout. The disturbance is evaluated for
+// every member at once as disturbance(position, velocity, acceleration).
+template <typename Disturbance>
+class NonlinearEnsembleSim {
+ public:
+  NonlinearEnsembleSim(Eigen::ArrayXd velocity_coefficient,
+                       Eigen::ArrayXd voltage_coefficient,
+                       Disturbance disturbance)
+      : velocity_coefficient_(std::move(velocity_coefficient)),
+        voltage_coefficient_(std::move(voltage_coefficient)),
+        disturbance_(std::move(disturbance)),
+        position_(Eigen::ArrayXd::Zero(Size())),
+        velocity_(Eigen::ArrayXd::Zero(Size())),
+        voltage_(Eigen::ArrayXd::Zero(Size())),
+        stage_position_(Size()),
+        stage_velocity_(Size()),
+        stage_acceleration_(Size()),
+        position_sum_(Size()),
+        velocity_sum_(Size()) {}
+
+  int Size() const { return static_cast<int>(velocity_coefficient_.size()); }
+
+  // Advances every member by `time_step` with the voltages in Voltage()
+  void Update(Time time_step) {
+    double h = time_step.in(au::seconds);
+
+    // NOTE(hayden): Stages are accumulated in place so a step doesn't
+    // allocate. Each stage's velocity is its position derivative.
+    stage_velocity_ = velocity_;
+    Acceleration(position_, velocity_);
+    position_sum_ = stage_velocity_;
+    velocity_sum_ = stage_acceleration_;
+
+    // k₂ and k₃ are evaluated half a step ahead and weighted twice, k₄ a full
+    // step ahead and weighted once
+    const double stage_times[] = {h / 2, h / 2, h};
+    const double stage_weights[] = {2, 2, 1};
+    for (int stage = 0; stage < 3; ++stage) {
+      stage_position_ = position_ + stage_times[stage] * stage_velocity_;
+      stage_velocity_ = velocity_ + stage_times[stage] * stage_acceleration_;
+      Acceleration(stage_position_, stage_velocity_);
+      position_sum_ += stage_weights[stage] * stage_velocity_;
+      velocity_sum_ += stage_weights[stage] * stage_acceleration_;
+    }
+
+    position_ += h / 6 * position_sum_;
+    velocity_ += h / 6 * velocity_sum_;
+  }
+
+  Eigen::ArrayXd &Position() { return position_; }
+
+  Eigen::ArrayXd &Velocity() { return velocity_; }
+
+  Eigen::ArrayXd &Voltage() { return voltage_; }
+
+ private:
+  void Acceleration(const Eigen::ArrayXd &position,
+                    const Eigen::ArrayXd &velocity) {
+    disturbance_(position, velocity, stage_acceleration_);
+    stage_acceleration_ +=
+        velocity_coefficient_ * velocity + voltage_coefficient_ * voltage_;
+  }
+
+  Eigen::ArrayXd velocity_coefficient_;
+  Eigen::ArrayXd voltage_coefficient_;
+  Disturbance disturbance_;
+  Eigen::ArrayXd position_;
+  Eigen::ArrayXd velocity_;
+  Eigen::ArrayXd voltage_;
+  Eigen::ArrayXd stage_position_;
+  Eigen::ArrayXd stage_velocity_;
+  Eigen::ArrayXd stage_acceleration_;
+  Eigen::ArrayXd position_sum_;
+  Eigen::ArrayXd velocity_sum_;
+};
+
+}  // namespace reefscape
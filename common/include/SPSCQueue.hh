@@ -0,0 +1,77 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+namespace reefscape {
+
+// Bounded lock-free queue for exactly one producer thread and one consumer
+// thread. Neither side blocks or allocates after construction.
+template <typename T>
+  requires std::is_trivially_copyable_v<T>
+class SPSCQueue {
+ public:
+  // Capacity is rounded up to a power of two so indices wrap with a mask
+  explicit SPSCQueue(std::size_t capacity)
+      : slots_(std::bit_ceil(std::max<std::size_t>(capacity, 2))),
+        mask_(slots_.size() - 1) {}
+
+  std::size_t Capacity() const { return slots_.size(); }
+
+  // Producer only; returns false without blocking when the queue is full
+  bool TryPush(const T &value) {
+    std::size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - cached_head_ == slots_.size()) {
+      cached_head_ = head_.load(std::memory_order_acquire);
+      if (tail - cached_head_ == slots_.size()) {
+        return false;
+      }
+    }
+
+    slots_[tail & mask_] = value;
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer only
+  std::optional<T> TryPop() {
+    std::size_t head = head_.load(std::memory_order_relaxed);
+    if (head == cached_tail_) {
+      cached_tail_ = tail_.load(std::memory_order_acquire);
+      if (head == cached_tail_) {
+        return std::nullopt;
+      }
+    }
+
+    T value = slots_[head & mask_];
+    head_.store(head + 1, std::memory_order_release);
+    return value;
+  }
+
+  bool Empty() const {
+    return head_.load(std::memory_order_acquire) ==
+           tail_.load(std::memory_order_acquire);
+  }
+
+ private:
+  // NOTE(hayden): Each index lives on its own cache line, next to the
+  // producer's or consumer's cached copy of the other index, so the two
+  // threads only share a line when one has to refresh its cached copy
+  static constexpr std::size_t kCacheLine = 64;
+
+  std::vector<T> slots_;
+  std::size_t mask_;
+
+  alignas(kCacheLine) std::atomic<std::size_t> head_ = 0;
+  std::size_t cached_tail_ = 0;
+
+  alignas(kCacheLine) std::atomic<std::size_t> tail_ = 0;
+  std::size_t cached_head_ = 0;
+};
+
+}  // namespace reefscape
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+#include "sample.hh"
+#include "units.hh"
+
+namespace reefscape {
+
+using namespace quantities;
+
+// The most recent samples in time order, for viewers that draw between ticks.
+// Samples may arrive in bursts; looking one up by time hides the bursts as
+// long as the time lags the newest sample.
+class SampleHistory {
+ public:
+  explicit SampleHistory(std::size_t capacity = 512);
+
+  // Adds a sample newer than every other. An older sample means the source
+  // restarted or seeked, so the history starts over from it.
+  void Add(const Sample &sample);
+
+  void Clear() { size_ = 0; }
+
+  bool Empty() const { return size_ == 0; }
+
+  // Time of the newest sample; the history must not be empty
+  Time Newest() const;
+
+  // Sample at `time`, interpolated between its neighbors. Past the newest
+  // sample, the position is extrapolated from its velocity for up to
+  // `max_extrapolation`; before the oldest, the oldest is held. The history
+  // must not be empty.
+  Sample At(Time time,
+            Time max_extrapolation = (au::milli(au::seconds))(50)) const;
+
+ private:
+  // Sample `index` places after the oldest
+  const Sample &Get(std::size_t index) const {
+    return samples_[(oldest_ + index) % samples_.size()];
+  }
+
+  std::vector<Sample> samples_;
+  std::size_t oldest_ = 0;
+  std::size_t size_ = 0;
+};
+
+// Advances a presentation time with the frame clock, trailing the newest
+// sample by a fixed delay. Small differences are corrected gradually so that
+// motion stays smooth when samples arrive in bursts; large ones snap.
+class PresentationClock {
+ public:
+  explicit PresentationClock(Time delay);
+
+  // Advances by `elapsed` towards `delay` before `newest`, and returns the
+  // time to present
+  Time Advance(Time elapsed, Time newest);
+
+ private:
+  Time delay_;
+  std::optional<Time> time_;
+};
+
+}  // namespace reefscape
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "sample.hh"
+
+namespace reefscape {
+
+// Lock-free ring of Samples in POSIX shared memory, written by one process
+// and read by any number of processes on the same host. Readers never block
+// the writer; a reader that falls more than a ring behind skips ahead and
+// counts the samples it missed.
+class SharedSampleRing {
+ public:
+  static constexpr std::uint64_t kCapacity = 4096;
+
+  // The writer replaces any segment `name` (e.g. "/reefscape") left by a
+  // previous run and unlinks it on destruction. Readers never create the
+  // segment; they attach once the writer has, so may start before it
+  SharedSampleRing(const std::string &name, bool writer);
+
+  SharedSampleRing(const SharedSampleRing &) = delete;
+  SharedSampleRing &operator=(const SharedSampleRing &) = delete;
+
+  ~SharedSampleRing();
+
+  // Writer only
+  void Write(const Sample &sample);
+
+  // Newest sample, if any has been written since this reader attached
+  std::optional<Sample> Latest() const;
+
+  // Appends every sample written since the last call to `samples`, oldest
+  // first
+  void Read(std::vector<Sample> &samples);
+
+  // Samples overwritten before this reader could read them
+  std::uint64_t Missed() const { return missed_; }
+
+ private:
+  static constexpr std::size_t kWords = sizeof(Sample) / sizeof(std::uint64_t);
+  static_assert(sizeof(Sample) % sizeof(std::uint64_t) == 0);
+
+  // NOTE(hayden): Each slot is a seqlock. The sequence is odd while the
+  // writer is inside the slot and 2·(index + 1) once sample `index` is
+  // complete, so a reader can tell both a torn read and an overwritten slot.
+  // The payload is stored as relaxed atomic words so that concurrent access
+  // is well-defined.
+  struct alignas(64) Slot {
+    std::atomic<std::uint64_t> sequence;
+    std::atomic<std::uint64_t> words[kWords];
+  };
+
+  struct Layout {
+    std::atomic<std::uint64_t> magic;
+    // Number of samples ever written
+    alignas(64) std::atomic<std::uint64_t> head;
+    Slot slots[kCapacity];
+  };
+
+  static_assert(sizeof(Slot) == 64);
+  static_assert(std::atomic<std::uint64_t>::is_always_lock_free);
+
+  // Maps an existing segment `name`, returning null if there is none yet
+  static Layout *Open(const std::string &name);
+
+  // Marks the segment `name`, if any, as retired so that its readers detach
+  static void Retire(const std::string &name);
+
+  // Readers only; returns whether the ring is attached to a live segment,
+  // reading a newly attached one from its first sample if `from_start`
+  bool Attach(bool from_start);
+
+  // Copies sample `index` into `sample`, returning false if the slot has
+  // already been reused or is being written
+  bool TryRead(std::uint64_t index, Sample &sample) const;
+
+  std::string name_;
+  bool writer_;
+  Layout *layout_ = nullptr;
+  std::uint64_t cursor_ = 0;
+  std::uint64_t missed_ = 0;
+};
+
+}  // namespace reefscape
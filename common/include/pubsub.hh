@@ -1,49 +1,81 @@
 #pragma once
 
-#include "input.hh"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "SharedSampleRing.hh"
 #include "ntcore_c.h"
-#include "state.hh"
-#include "units.hh"
+#include "sample.hh"
 
 namespace reefscape {
 
 struct Publisher {
   NT_Inst instance;
-  NT_Publisher position;
-  NT_Publisher velocity;
-  NT_Publisher reference_position;
-  NT_Publisher reference_velocity;
-  NT_Publisher voltage;
-  NT_Publisher at_goal;
+  NT_Publisher sample;
+  // Shared-memory ring for viewers on this host, if any
+  std::unique_ptr<SharedSampleRing> ring;
 
   Publisher(NT_Inst instance);
 
-  void Publish(PositionVelocityState state, PositionVelocityState reference,
-               VoltageInput input, bool at_goal) const;
+  // Also writes every sample to the shared-memory ring `shm_name`, while NT
+  // remains available to remote dashboards
+  Publisher(NT_Inst instance, const std::string &shm_name);
+
+  void Publish(const Sample &sample) const;
+
+  // Queues `sample` on the NT topic only, leaving the flush to the caller
+  void Send(const Sample &sample) const;
+};
+
+struct TimestampedSample {
+  // NT time the sample was received (or read, from shared memory), in
+  // microseconds
+  std::int64_t time;
+  Sample sample;
 };
 
 struct Subscriber {
-  NT_Inst instance;
-  NT_Subscriber position;
-  NT_Subscriber velocity;
-  NT_Subscriber reference_position;
-  NT_Subscriber reference_velocity;
-  NT_Subscriber voltage;
-  NT_Subscriber at_goal;
+  NT_Inst instance = 0;
+  NT_Subscriber sample = 0;
+  std::unique_ptr<SharedSampleRing> ring;
+  std::vector<Sample> ring_samples;
 
-  Subscriber(NT_Inst instance);
+  // Keeps up to `queue_size` samples received between calls to Drain, for
+  // consumers that run slower than the sim but need every tick
+  Subscriber(NT_Inst instance, std::size_t queue_size = 0);
 
-  quantities::Displacement Position() const;
+  // Reads from the shared-memory ring written by a Publisher on this host
+  // instead of NT. Every sample is kept for Drain, up to the ring capacity.
+  explicit Subscriber(const std::string &shm_name);
 
-  quantities::LinearVelocity Velocity() const;
+  // Most recently received sample, or a zeroed sample before the first
+  Sample Latest() const;
 
-  quantities::Displacement ReferencePosition() const;
+  // Replaces the contents of `samples` with every sample received since the
+  // last call, oldest first
+  void Drain(std::vector<TimestampedSample> &samples);
+};
+
+// Publishes the positions of an ensemble of elevators, one array per update
+struct EnsemblePublisher {
+  NT_Publisher position;
+
+  EnsemblePublisher(NT_Inst instance);
 
-  quantities::LinearVelocity ReferenceVelocity() const;
+  void Publish(std::span<const double> positions) const;
+};
+
+struct EnsembleSubscriber {
+  NT_Subscriber position;
 
-  quantities::Voltage Voltage() const;
+  EnsembleSubscriber(NT_Inst instance);
 
-  bool AtGoal() const;
+  // Most recently received positions, in meters, or none before the first
+  std::vector<double> Latest() const;
 };
 
 };  // namespace reefscape
@@ -59,13 +59,11 @@ const Displacement kCarriageHeight = au::inches(6.0);
 const Displacement kTotalTravel =
     kStageTwoTravel + kStageThreeTravel + kCarriageTravel;
 
-const std::string_view kElevatorPositionKey = "/elevator/position";
-const std::string_view kElevatorVelocityKey = "/elevator/velocity";
-const std::string_view kElevatorReferencePositionKey =
-    "/elevator/reference_position";
-const std::string_view kElevatorReferenceVelocityKey =
-    "/elevator/reference_velocity";
-const std::string_view kElevatorVoltageKey = "/elevator/voltage";
-const std::string_view kElevatorAtGoalKey = "/elevator/at_goal";
+// NOTE(hayden): One topic carries every value of a tick so that subscribers
+// never see values from different ticks
+const std::string_view kElevatorSampleKey = "/elevator/sample";
+
+// Position of every member of an ensemble run, in meters
+const std::string_view kEnsemblePositionKey = "/ensemble/position";
 
 }  // namespace reefscape
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+#include "input.hh"
+#include "state.hh"
+#include "units.hh"
+
+namespace reefscape {
+
+// One tick of the elevator loop in a fixed binary layout, shared by the
+// telemetry log and the live transports
+struct Sample {
+  // Simulation time in microseconds
+  std::int64_t timestamp;
+  double position;
+  double velocity;
+  double reference_position;
+  double reference_velocity;
+  double voltage;
+  std::uint8_t at_goal;
+  std::uint8_t padding[7];
+
+  static Sample From(quantities::Time time, PositionVelocityState state,
+                     PositionVelocityState reference, VoltageInput input,
+                     bool at_goal) {
+    return {static_cast<std::int64_t>(
+                std::llround(time.in(au::micro(au::seconds)))),
+            state.Position().in(au::meters),
+            state.Velocity().in(au::meters / au::second),
+            reference.Position().in(au::meters),
+            reference.Velocity().in(au::meters / au::second),
+            input.Voltage().in(au::volts),
+            static_cast<std::uint8_t>(at_goal),
+            {}};
+  }
+
+  quantities::Time Time() const {
+    return (au::micro(au::seconds))(static_cast<double>(timestamp));
+  }
+
+  PositionVelocityState State() const {
+    return {au::meters(position), (au::meters / au::second)(velocity)};
+  }
+
+  PositionVelocityState Reference() const {
+    return {au::meters(reference_position),
+            (au::meters / au::second)(reference_velocity)};
+  }
+
+  quantities::Voltage Voltage() const { return au::volts(voltage); }
+
+  bool AtGoal() const { return at_goal != 0; }
+};
+
+// NOTE(hayden): The layout is the on-disk and on-wire format, so changing it
+// requires bumping the telemetry log version
+static_assert(sizeof(Sample) == 56);
+static_assert(std::is_trivially_copyable_v<Sample>);
+
+// WPILib struct schema for Sample, so that NT tools can decode the raw topic.
+// WPILib structs are packed and little-endian, which matches Sample on every
+// target we build for.
+const std::string_view kSampleTypeString = "struct:ElevatorSample";
+const std::string_view kSampleSchema =
+    "int64 timestamp;double position;double velocity;"
+    "double reference_position;double reference_velocity;double voltage;"
+    "bool at_goal;uint8 padding[7]";
+
+}  // namespace reefscape
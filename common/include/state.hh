@@ -22,7 +22,7 @@ struct PositionVelocityState {
 
   PositionVelocityState(const StateVector<Dimension>& state)
       : PositionVelocityState(au::meters(state[0]),
-                              (au::meters / au::second)(0)) {}
+                              (au::meters / au::second)(state[1])) {}
 
   PositionVelocityState& operator=(const StateVector<Dimension>& state) {
     this->vector[0] = state[0];
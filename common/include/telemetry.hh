@@ -0,0 +1,166 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <span>
+#include <stop_token>
+#include <string>
+#include <thread>
+
+#include "SPSCQueue.hh"
+#include "sample.hh"
+#include "units.hh"
+
+namespace reefscape {
+
+// A telemetry log is this header followed by fixed-size Samples in timestamp
+// order. Since records are fixed-size and sorted, the records themselves are
+// the time index and a reader seeks by binary search without a side table.
+struct TelemetryHeader {
+  static constexpr char kMagic[8] = {'R', 'E', 'E', 'F', 'L', 'O', 'G', '\0'};
+  static constexpr std::uint32_t kVersion = 1;
+
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t record_size;
+};
+
+static_assert(sizeof(TelemetryHeader) % alignof(Sample) == 0);
+
+// Appends samples to a telemetry log from a background thread so that the
+// loop never waits on the disk
+class TelemetryRecorder {
+ public:
+  explicit TelemetryRecorder(const std::string &path,
+                             std::size_t capacity = std::size_t{1} << 16);
+
+  TelemetryRecorder(const TelemetryRecorder &) = delete;
+  TelemetryRecorder &operator=(const TelemetryRecorder &) = delete;
+
+  // Flushes every queued sample before closing the log
+  ~TelemetryRecorder();
+
+  // Queues `sample`, returning false without blocking if the writer has
+  // fallen a full queue behind
+  bool TryRecord(const Sample &sample) { return queue_.TryPush(sample); }
+
+  // Queues `sample`, dropping it if the writer has fallen behind
+  void Record(const Sample &sample) {
+    if (!TryRecord(sample)) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  // Samples queued too late or that failed to reach the log
+  std::size_t Dropped() const {
+    return dropped_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  void Write(std::stop_token stop_token);
+
+  // Writes every queued sample, returning how many were written
+  std::size_t Drain();
+
+  std::FILE *file_;
+  SPSCQueue<Sample> queue_;
+  std::atomic<std::size_t> dropped_ = 0;
+  // Only touched by the writer thread
+  bool write_failed_ = false;
+  std::jthread writer_;
+};
+
+// Read-only, memory-mapped view of a telemetry log. A trailing partial record
+// (e.g. from a log that is still being written) is ignored.
+class TelemetryLog {
+ public:
+  explicit TelemetryLog(const std::string &path);
+
+  TelemetryLog(const TelemetryLog &) = delete;
+  TelemetryLog &operator=(const TelemetryLog &) = delete;
+
+  ~TelemetryLog();
+
+  std::span<const Sample> Samples() const { return {samples_, size_}; }
+
+  std::size_t Size() const { return size_; }
+
+  bool Empty() const { return size_ == 0; }
+
+  const Sample &operator[](std::size_t index) const { return samples_[index]; }
+
+  // Index of the first sample at or after `time` in O(log n), or Size() if
+  // there is none
+  std::size_t Seek(quantities::Time time) const;
+
+  quantities::Time StartTime() const;
+
+  quantities::Time EndTime() const;
+
+ private:
+  void *mapping_ = nullptr;
+  std::size_t mapping_length_ = 0;
+  const Sample *samples_ = nullptr;
+  std::size_t size_ = 0;
+};
+
+// Plays back a telemetry log at an adjustable speed
+class TelemetryPlayer {
+ public:
+  explicit TelemetryPlayer(const TelemetryLog &log, double speed = 1.0);
+
+  // Advances playback by `elapsed` wall time and returns the samples played
+  // since the last call. Playback stops at the end of the log.
+  std::span<const Sample> Advance(quantities::Time elapsed);
+
+  // Moves playback to `time`, clamped to the extent of the log
+  void Seek(quantities::Time time);
+
+  // Most recently played sample
+  Sample Current() const;
+
+  quantities::Time Time() const { return time_; }
+
+  double Speed() const { return speed_; }
+
+  void SetSpeed(double speed) { speed_ = speed; }
+
+  bool Finished() const { return cursor_ == log_.Size(); }
+
+ private:
+  // Index of the first sample after time_
+  std::size_t Cursor() const;
+
+  const TelemetryLog &log_;
+  double speed_;
+  quantities::Time time_;
+  // Index of the first sample not yet played
+  std::size_t cursor_ = 0;
+};
+
+// Where a viewer reads samples from: a telemetry log, a shared-memory ring, or
+// else NT
+struct ViewerOptions {
+  // Telemetry log to play instead of connecting to the simulation
+  std::string replay;
+  double speed = 1.0;
+  // Shared-memory ring to read instead of connecting over NT
+  std::string shm;
+  // Chrome trace file to append to, if any
+  std::string trace;
+};
+
+// Usage of the options parsed by ParseViewerOption
+extern const char *const kViewerUsage;
+
+// Parses `argv[i]` into `options` if it is a viewer option, advancing `i` past
+// its value. Returns false if it is not one.
+bool ParseViewerOption(int argc, char *argv[], int &i, ViewerOptions &options);
+
+// [ and ] seek by five seconds, - and = halve and double the playback speed.
+// Returns true if playback jumped.
+bool HandleReplayKeys(TelemetryPlayer &player);
+
+}  // namespace reefscape
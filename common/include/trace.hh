@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Opt-in tracing to the Chrome trace event format, for viewing in Perfetto or
+// chrome://tracing. Events are timestamped with CLOCK_MONOTONIC, so traces
+// from several processes on one host line up when written to the same file.
+//
+// Each thread records into its own bounded buffer without locking. Event
+// and counter names must outlive the process (i.e. be string literals),
+// since only the pointer is recorded.
+namespace reefscape::trace {
+
+namespace internal {
+
+extern std::atomic<bool> enabled;
+
+void Append(const char *name, char phase, double value);
+
+}  // namespace internal
+
+// Starts recording. Each thread keeps at most `capacity` events; later events
+// are dropped and counted.
+void Start(const std::string &path, std::string_view process_name,
+           std::size_t capacity = std::size_t{1} << 20);
+
+// Stops recording and appends every event to the trace file. The file is
+// locked while writing, so several processes may share it.
+void Stop();
+
+inline bool Enabled() {
+  return internal::enabled.load(std::memory_order_relaxed);
+}
+
+inline void Begin(const char *name) {
+  if (Enabled()) {
+    internal::Append(name, 'B', 0);
+  }
+}
+
+inline void End(const char *name) {
+  if (Enabled()) {
+    internal::Append(name, 'E', 0);
+  }
+}
+
+inline void Counter(const char *name, double value) {
+  if (Enabled()) {
+    internal::Append(name, 'C', value);
+  }
+}
+
+// Begins an event on construction and ends it on destruction
+class Scope {
+ public:
+  explicit Scope(const char *name) : name_(Enabled() ? name : nullptr) {
+    if (name_ != nullptr) {
+      internal::Append(name_, 'B', 0);
+    }
+  }
+
+  Scope(const Scope &) = delete;
+  Scope &operator=(const Scope &) = delete;
+
+  ~Scope() {
+    if (name_ != nullptr) {
+      internal::Append(name_, 'E', 0);
+    }
+  }
+
+ private:
+  const char *name_;
+};
+
+}  // namespace reefscape::trace
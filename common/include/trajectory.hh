@@ -1,45 +1,58 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <span>
+
 #include "MotorSystem.hh"
 #include "state.hh"
 #include "units.hh"
 
 namespace reefscape {
 
+// Trapezoid motion profile planned once from a start state to a goal, which
+// can then be sampled at any time since the start in O(1)
 template <typename NativeUnit>
-struct TrapezoidTrajectory {
+struct TrapezoidProfile {
   au::QuantityD<units::Velocity<NativeUnit>> max_velocity;
   au::QuantityD<units::Acceleration<NativeUnit>> max_acceleration;
+  // NOTE(hayden): Start and goal are stored flipped when moving in the
+  // negative direction
+  PositionVelocityState start;
+  PositionVelocityState goal;
+  bool flip;
+  quantities::Time end_acceleration;
+  quantities::Time end_cruise;
+  quantities::Time end_deceleration;
 
-  template <typename System>
-    requires MotorSystem<System, NativeUnit>
-  TrapezoidTrajectory(const System& system)
-      : max_velocity(MaximumVelocity<System, NativeUnit>(system)),
-        max_acceleration(MaximumAcceleration<System, NativeUnit>(system)) {}
-
-  // TODO(hayden): Generate trajectories in NativeUnit
-  PositionVelocityState Calculate(quantities::Time time_step,
-                                  PositionVelocityState state,
-                                  PositionVelocityState goal) {
-    // NOTE(hayden): Algorithm assumes positive motion
-    bool flip = goal.Position() < state.Position();
+  TrapezoidProfile(
+      au::QuantityD<units::Velocity<NativeUnit>> max_velocity,
+      au::QuantityD<units::Acceleration<NativeUnit>> max_acceleration,
+      PositionVelocityState state, PositionVelocityState goal)
+      : max_velocity(max_velocity),
+        max_acceleration(max_acceleration),
+        start(state),
+        goal(goal),
+        // NOTE(hayden): Algorithm assumes positive motion
+        flip(goal.Position() < state.Position()) {
     if (flip) {
-      state.vector = -state.vector;
-      goal.vector = -goal.vector;
+      start.vector = -start.vector;
+      this->goal.vector = -this->goal.vector;
     }
 
-    if (state.Velocity() > max_velocity) {
-      state.SetVelocity(max_velocity);
+    if (start.Velocity() > max_velocity) {
+      start.SetVelocity(max_velocity);
     }
 
-    auto start_time = state.Velocity() / max_acceleration;
+    auto start_time = start.Velocity() / max_acceleration;
     auto start_distance = 0.5 * start_time * start_time * max_acceleration;
 
-    auto end_time = goal.Velocity() / max_acceleration;
+    auto end_time = this->goal.Velocity() / max_acceleration;
     auto end_distance = 0.5 * end_time * end_time * max_acceleration;
 
-    auto distance =
-        start_distance + (goal.Position() - state.Position()) + end_distance;
+    auto distance = start_distance +
+                    (this->goal.Position() - start.Position()) + end_distance;
     auto acceleration_time = max_velocity / max_acceleration;
     auto cruise_distance =
         distance - (acceleration_time * acceleration_time * max_acceleration);
@@ -47,26 +60,31 @@ struct TrapezoidTrajectory {
       acceleration_time = au::sqrt(distance / max_acceleration);
       cruise_distance = au::meters(0);
     }
-    auto end_acceleration = acceleration_time - start_time;
-    auto end_cruise = end_acceleration + cruise_distance / max_velocity;
-    auto end_deceleration = end_cruise + acceleration_time - end_time;
+    end_acceleration = acceleration_time - start_time;
+    end_cruise = end_acceleration + cruise_distance / max_velocity;
+    end_deceleration = end_cruise + acceleration_time - end_time;
+  }
+
+  quantities::Time TotalTime() const { return end_deceleration; }
 
-    PositionVelocityState result{state};
+  // State `time` after the start of the profile
+  PositionVelocityState Sample(quantities::Time time) const {
+    PositionVelocityState result{start};
 
-    if (time_step < end_acceleration) {
+    if (time < end_acceleration) {
       result.SetPosition(
-          result.Position() +
-          (state.Velocity() + 0.5 * time_step * max_acceleration) * time_step);
-      result.SetVelocity(result.Velocity() + time_step * max_acceleration);
-    } else if (time_step <= end_cruise) {
+          start.Position() +
+          (start.Velocity() + 0.5 * time * max_acceleration) * time);
+      result.SetVelocity(start.Velocity() + time * max_acceleration);
+    } else if (time <= end_cruise) {
       result.SetPosition(
-          state.Position() +
-          (state.Velocity() + 0.5 * end_acceleration * max_acceleration) *
+          start.Position() +
+          (start.Velocity() + 0.5 * end_acceleration * max_acceleration) *
               end_acceleration +
-          max_velocity * (time_step - end_acceleration));
+          max_velocity * (time - end_acceleration));
       result.SetVelocity(max_velocity);
-    } else if (time_step <= end_deceleration) {
-      auto time_left = end_deceleration - time_step;
+    } else if (time <= end_deceleration) {
+      auto time_left = end_deceleration - time;
       result.SetPosition(
           goal.Position() -
           time_left * (goal.Velocity() + 0.5 * time_left * max_acceleration));
@@ -81,6 +99,65 @@ struct TrapezoidTrajectory {
 
     return result;
   }
+
+  // Samples `horizon.size()` states spaced `time_step` apart, beginning at
+  // `start_time`
+  void Sample(quantities::Time start_time, quantities::Time time_step,
+              std::span<PositionVelocityState> horizon) const {
+    for (std::size_t i = 0; i < horizon.size(); ++i) {
+      horizon[i] = Sample(start_time + static_cast<double>(i) * time_step);
+    }
+  }
+};
+
+template <typename NativeUnit>
+struct TrapezoidTrajectory {
+  au::QuantityD<units::Velocity<NativeUnit>> max_velocity;
+  au::QuantityD<units::Acceleration<NativeUnit>> max_acceleration;
+
+  template <typename System>
+    requires MotorSystem<System, NativeUnit>
+  TrapezoidTrajectory(const System& system)
+      : max_velocity(MaximumVelocity<System, NativeUnit>(system)),
+        max_acceleration(MaximumAcceleration<System, NativeUnit>(system)) {}
+
+  // Plans a profile from `state` to `goal`, reusing a recent plan with the same
+  // endpoints (e.g. when cycling between fixed setpoints)
+  TrapezoidProfile<NativeUnit> Plan(PositionVelocityState state,
+                                    PositionVelocityState goal) {
+    for (const auto& entry : profile_cache_) {
+      if (entry && entry->state == state.vector &&
+          entry->goal == goal.vector) {
+        return entry->profile;
+      }
+    }
+
+    TrapezoidProfile<NativeUnit> profile{max_velocity, max_acceleration, state,
+                                         goal};
+    profile_cache_[next_cache_entry_].emplace(state.vector, goal.vector,
+                                              profile);
+    next_cache_entry_ = (next_cache_entry_ + 1) % profile_cache_.size();
+    return profile;
+  }
+
+  // TODO(hayden): Generate trajectories in NativeUnit
+  PositionVelocityState Calculate(quantities::Time time_step,
+                                  PositionVelocityState state,
+                                  PositionVelocityState goal) {
+    return TrapezoidProfile<NativeUnit>{max_velocity, max_acceleration, state,
+                                        goal}
+        .Sample(time_step);
+  }
+
+ private:
+  struct CacheEntry {
+    StateVector<PositionVelocityState::Dimension> state;
+    StateVector<PositionVelocityState::Dimension> goal;
+    TrapezoidProfile<NativeUnit> profile;
+  };
+
+  std::array<std::optional<CacheEntry>, 8> profile_cache_;
+  std::size_t next_cache_entry_ = 0;
 };
 
 }  // namespace reefscape
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <type_traits>
+
 #include "au/fwd.hh"
 #include "au/prefix.hh"
 #include "au/quantity.hh"
@@ -101,6 +103,14 @@ using LinearVoltageCoefficient =
 using AngularVoltageCoefficient =
     au::QuantityD<units::AngularVoltageCoefficientUnit>;
 
+// NOTE(hayden): Quantities must stay layout-identical to double so that they
+// can be passed in registers and stored in Eigen and telemetry buffers as-is
+static_assert(sizeof(Voltage) == sizeof(double));
+static_assert(sizeof(LinearVelocity) == sizeof(double));
+static_assert(std::is_trivially_copyable_v<Voltage>);
+static_assert(std::is_trivially_copyable_v<LinearVelocity>);
+static_assert(std::is_trivially_copyable_v<Time>);
+
 }  // namespace quantities
 
 }  // namespace reefscape
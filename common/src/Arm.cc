@@ -1,5 +1,7 @@
 #include "Arm.hh"
 
+#include <cmath>
+
 #include "units.hh"
 
 namespace reefscape {
@@ -39,4 +41,12 @@ quantities::Torque Arm::Torque(AngularVelocity velocity,
   return voltage_torque + back_emf_torque;
 }
 
+AngularAcceleration Arm::GravityAcceleration(Angle angle,
+                                             LinearAcceleration gravity) const {
+  // τ = m·g·r·cos(θ), so α = τ/I
+  quantities::Torque torque =
+      mass * gravity * center_of_mass * std::cos(angle.in(au::radians));
+  return torque * au::radians(1) / moment_of_inertia;
+}
+
 }  // namespace reefscape
@@ -0,0 +1,64 @@
+#include "AsyncPublisher.hh"
+
+#include <chrono>
+#include <utility>
+
+#include "ntcore_cpp.h"
+
+namespace reefscape {
+
+AsyncPublisher::AsyncPublisher(Publisher publisher, std::size_t capacity)
+    : publisher_(std::move(publisher)), queue_(capacity) {
+  thread_ =
+      std::jthread{[this](std::stop_token stop_token) { Run(stop_token); }};
+}
+
+AsyncPublisher::~AsyncPublisher() {
+  thread_.request_stop();
+  thread_.join();
+}
+
+void AsyncPublisher::Publish(const Sample &sample) {
+  // NOTE(hayden): The ring write is wait-free and local viewers want it as
+  // soon as possible, so it stays on the calling thread
+  if (publisher_.ring) {
+    publisher_.ring->Write(sample);
+  }
+
+  if (!queue_.TryPush(sample)) {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void AsyncPublisher::Run(std::stop_token stop_token) {
+  while (!stop_token.stop_requested()) {
+    if (Drain() == 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+
+  Drain();
+}
+
+std::size_t AsyncPublisher::Drain() {
+  // NOTE(hayden): At most a queue's worth per flush, so a producer that keeps
+  // up with the drain can't postpone the flush indefinitely
+  std::size_t count = 0;
+  while (count < queue_.Capacity()) {
+    auto sample = queue_.TryPop();
+    if (!sample) {
+      break;
+    }
+    publisher_.Send(*sample);
+    ++count;
+  }
+
+  if (count != 0) {
+    nt::Flush(publisher_.instance);
+    sent_.fetch_add(count, std::memory_order_relaxed);
+    flushes_.fetch_add(1, std::memory_order_relaxed);
+  }
+  return count;
+}
+
+}  // namespace reefscape
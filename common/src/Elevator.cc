@@ -6,18 +6,6 @@
 
 namespace reefscape {
 
-LinearVelocityCoefficient Elevator::VelocityCoefficient() const {
-  return -1 *
-         (gear_ratio * gear_ratio * motor.torque_constant_ * au::radians(1)) /
-         (motor.resistance_ * drum_radius * drum_radius * mass *
-          motor.angular_velocity_constant_);
-}
-
-LinearVoltageCoefficient Elevator::VoltageCoefficient() const {
-  return (gear_ratio * motor.torque_constant_) /
-         (motor.resistance_ * mass * drum_radius);
-}
-
 AngularVelocity Elevator::MotorVelocity(LinearVelocity velocity) const {
   return velocity * au::radians(1) * gear_ratio / drum_radius;
 }
@@ -0,0 +1,38 @@
+#include "LQR.hh"
+
+#include "Elevator.hh"
+#include "input.hh"
+#include "state.hh"
+#include "units.hh"
+
+namespace reefscape {
+
+ElevatorGainSchedule MakeElevatorGainSchedule(
+    const Elevator &elevator, std::span<const GearRatio> gear_ratios,
+    Mass min_mass, Mass max_mass, int masses, Time time_step,
+    const SystemMatrix<PositionVelocityState::Dimension> &Q,
+    const InputCostMatrix<VoltageInput::Dimension> &R) {
+  ElevatorGainSchedule schedule{static_cast<int>(gear_ratios.size()),
+                                min_mass, max_mass, masses};
+
+  for (int configuration = 0; configuration < schedule.Configurations();
+       ++configuration) {
+    for (int mass_index = 0; mass_index < schedule.Masses(); ++mass_index) {
+      Elevator variant = elevator;
+      variant.gear_ratio = gear_ratios[configuration];
+      variant.mass = schedule.MassAt(mass_index);
+
+      auto continuous_matrices = std::make_pair(
+          variant.ContinuousSystemMatrix<PositionVelocityState>(),
+          variant.ContinuousInputMatrix<PositionVelocityState,
+                                        VoltageInput>());
+      auto discrete_matrices = Discretize(continuous_matrices, time_step);
+      schedule.Set(configuration, mass_index,
+                   LQR(discrete_matrices, Q, R));
+    }
+  }
+
+  return schedule;
+}
+
+}  // namespace reefscape
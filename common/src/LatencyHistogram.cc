@@ -0,0 +1,93 @@
+#include "LatencyHistogram.hh"
+
+#include <cmath>
+#include <utility>
+
+#include "ntcore_cpp.h"
+
+namespace reefscape {
+
+std::uint64_t LatencyHistogram::Count() const {
+  std::uint64_t count = 0;
+  for (const auto &bucket : buckets_) {
+    count += bucket.load(std::memory_order_relaxed);
+  }
+  return count;
+}
+
+std::uint64_t LatencyHistogram::Quantile(double quantile) const {
+  // NOTE(hayden): Buckets are copied first so the count and the walk agree
+  // while the loop keeps recording
+  std::array<std::uint64_t, kBuckets> counts;
+  std::uint64_t total = 0;
+  for (int i = 0; i < kBuckets; ++i) {
+    counts[i] = buckets_[i].load(std::memory_order_relaxed);
+    total += counts[i];
+  }
+  if (total == 0) {
+    return 0;
+  }
+
+  auto rank = static_cast<std::uint64_t>(
+      std::ceil(std::clamp(quantile, 0.0, 1.0) * static_cast<double>(total)));
+  rank = std::max<std::uint64_t>(rank, 1);
+
+  std::uint64_t seen = 0;
+  for (int i = 0; i < kBuckets; ++i) {
+    seen += counts[i];
+    if (seen >= rank) {
+      return std::min(UpperBound(i), Max());
+    }
+  }
+  return Max();
+}
+
+std::ostream &operator<<(std::ostream &stream,
+                         const LatencyHistogram &histogram) {
+  auto microseconds = [&](double quantile) {
+    return histogram.Quantile(quantile) / 1e3;
+  };
+  return stream << histogram.Count() << " samples, p50 " << microseconds(0.5)
+                << " us, p90 " << microseconds(0.9) << " us, p99 "
+                << microseconds(0.99) << " us, p99.9 " << microseconds(0.999)
+                << " us, max " << histogram.Max() / 1e3 << " us";
+}
+
+LatencyPublisher::LatencyPublisher(NT_Inst instance, std::string_view prefix,
+                                   std::vector<NamedHistogram> histograms,
+                                   quantities::Time period)
+    : histograms_(std::move(histograms)),
+      period_(std::llround(period.in(au::nano(au::seconds)))) {
+  for (const auto &histogram : histograms_) {
+    std::string key = std::string{prefix} + "/" + histogram.name;
+    publishers_.push_back(nt::Publish(nt::GetTopic(instance, key),
+                                      NT_DOUBLE_ARRAY, "double[]"));
+  }
+
+  thread_ =
+      std::jthread{[this](std::stop_token stop_token) { Run(stop_token); }};
+}
+
+void LatencyPublisher::Run(std::stop_token stop_token) {
+  while (!stop_token.stop_requested()) {
+    for (std::size_t i = 0; i < histograms_.size(); ++i) {
+      const LatencyHistogram &histogram = *histograms_[i].histogram;
+      double values[] = {static_cast<double>(histogram.Count()),
+                         histogram.Quantile(0.5) / 1e3,
+                         histogram.Quantile(0.9) / 1e3,
+                         histogram.Quantile(0.99) / 1e3,
+                         histogram.Quantile(0.999) / 1e3,
+                         histogram.Max() / 1e3};
+      nt::SetDoubleArray(publishers_[i], values);
+    }
+
+    // NOTE(hayden): Sleeping in slices keeps shutdown prompt
+    auto wake_time = std::chrono::steady_clock::now() + period_;
+    while (!stop_token.stop_requested() &&
+           std::chrono::steady_clock::now() < wake_time) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  }
+}
+
+}  // namespace reefscape
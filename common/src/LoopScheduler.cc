@@ -0,0 +1,119 @@
+#include "LoopScheduler.hh"
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <time.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+namespace reefscape {
+
+namespace {
+
+constexpr std::int64_t kNanosecondsPerSecond = 1'000'000'000;
+
+std::int64_t Now() {
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * kNanosecondsPerSecond + now.tv_nsec;
+}
+
+void SleepUntil(std::int64_t deadline) {
+  timespec time{static_cast<time_t>(deadline / kNanosecondsPerSecond),
+                static_cast<long>(deadline % kNanosecondsPerSecond)};
+  // NOTE(hayden): An absolute deadline is unaffected by interruption, so
+  // retrying after a signal doesn't extend the sleep
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &time, nullptr) ==
+         EINTR) {
+  }
+}
+
+void Warn(const char *what, int error) {
+  std::cerr << "warning: " << what << ": " << std::strerror(error)
+            << std::endl;
+}
+
+}  // namespace
+
+std::ostream &operator<<(std::ostream &stream,
+                         const LoopStatistics &statistics) {
+  return stream << statistics.cycles << " cycles, " << statistics.overruns
+                << " overruns, " << statistics.resyncs << " resyncs, lateness "
+                << statistics.mean_lateness / 1e3 << " us mean / "
+                << statistics.max_lateness / 1e3 << " us max, period "
+                << statistics.min_period / 1e3 << " us to "
+                << statistics.max_period / 1e3 << " us";
+}
+
+LoopScheduler::LoopScheduler(quantities::Time period,
+                             const LoopSchedulerOptions &options)
+    : period_(std::llround(period.in(au::nano(au::seconds)))) {
+  if (options.lock_memory && mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+    Warn("mlockall", errno);
+  }
+
+  if (options.cpu >= 0) {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(options.cpu, &cpus);
+    int error = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    if (error != 0) {
+      Warn("pthread_setaffinity_np", error);
+    }
+  }
+
+  if (options.realtime) {
+    sched_param parameters{};
+    parameters.sched_priority =
+        std::clamp(options.priority, sched_get_priority_min(SCHED_FIFO),
+                   sched_get_priority_max(SCHED_FIFO));
+    int error =
+        pthread_setschedparam(pthread_self(), SCHED_FIFO, &parameters);
+    if (error != 0) {
+      Warn("pthread_setschedparam", error);
+    }
+  }
+
+  deadline_ = Now();
+}
+
+quantities::Time LoopScheduler::Wait() {
+  deadline_ += period_;
+
+  std::int64_t now = Now();
+  if (now > deadline_) {
+    ++statistics_.overruns;
+    if (now - deadline_ > kMaxBehind * period_) {
+      ++statistics_.resyncs;
+      deadline_ = now;
+    }
+  } else {
+    SleepUntil(deadline_);
+    now = Now();
+  }
+
+  std::int64_t lateness = std::max<std::int64_t>(now - deadline_, 0);
+  ++statistics_.cycles;
+  total_lateness_ += lateness;
+  statistics_.mean_lateness = total_lateness_ / statistics_.cycles;
+  statistics_.max_lateness = std::max(statistics_.max_lateness, lateness);
+
+  std::int64_t measured_period = period_;
+  if (last_wakeup_ >= 0) {
+    measured_period = now - last_wakeup_;
+    if (statistics_.cycles == 2) {
+      statistics_.min_period = statistics_.max_period = measured_period;
+    }
+    statistics_.min_period = std::min(statistics_.min_period, measured_period);
+    statistics_.max_period = std::max(statistics_.max_period, measured_period);
+  }
+  last_wakeup_ = now;
+  return (au::nano(au::seconds))(static_cast<double>(measured_period));
+}
+
+}  // namespace reefscape
@@ -0,0 +1,118 @@
+#include "SampleHistory.hh"
+
+#include <algorithm>
+#include <cmath>
+
+namespace reefscape {
+
+namespace {
+
+// NOTE(hayden): Beyond this the source has restarted or seeked, and easing
+// towards the new time would replay or skip the gap in slow motion
+const Time kMaxCorrection = (au::milli(au::seconds))(250);
+
+// Fraction of the remaining difference corrected per second
+const double kCorrectionRate = 2.0;
+
+}  // namespace
+
+SampleHistory::SampleHistory(std::size_t capacity)
+    : samples_(std::max<std::size_t>(capacity, 2)) {}
+
+void SampleHistory::Add(const Sample &sample) {
+  if (size_ > 0 && sample.timestamp <= Get(size_ - 1).timestamp) {
+    if (sample.timestamp == Get(size_ - 1).timestamp) {
+      return;
+    }
+    size_ = 0;
+  }
+
+  if (size_ == samples_.size()) {
+    oldest_ = (oldest_ + 1) % samples_.size();
+    --size_;
+  }
+  samples_[(oldest_ + size_) % samples_.size()] = sample;
+  ++size_;
+}
+
+Time SampleHistory::Newest() const { return Get(size_ - 1).Time(); }
+
+Sample SampleHistory::At(Time time, Time max_extrapolation) const {
+  double microseconds = time.in(au::micro(au::seconds));
+
+  const Sample &newest = Get(size_ - 1);
+  if (microseconds >= newest.timestamp) {
+    double ahead = std::min(microseconds - newest.timestamp,
+                            max_extrapolation.in(au::micro(au::seconds)));
+    Sample result = newest;
+    result.position += newest.velocity * ahead * 1e-6;
+    result.reference_position += newest.reference_velocity * ahead * 1e-6;
+    return result;
+  }
+
+  const Sample &oldest = Get(0);
+  if (microseconds <= oldest.timestamp) {
+    return oldest;
+  }
+
+  // First sample after `time`, which exists and isn't the oldest
+  std::size_t low = 1;
+  std::size_t high = size_ - 1;
+  while (low < high) {
+    std::size_t middle = low + (high - low) / 2;
+    if (Get(middle).timestamp <= microseconds) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  const Sample &before = Get(low - 1);
+  const Sample &after = Get(low);
+
+  // NOTE(hayden): Position is interpolated with a cubic Hermite spline
+  // through both velocities, so it stays smooth across samples when drawn
+  // at a higher rate than the sim runs
+  double dt = (after.timestamp - before.timestamp) * 1e-6;
+  double t = (microseconds - before.timestamp) /
+             static_cast<double>(after.timestamp - before.timestamp);
+  double t2 = t * t;
+  double t3 = t2 * t;
+  auto hermite = [&](double p0, double v0, double p1, double v1) {
+    return (2 * t3 - 3 * t2 + 1) * p0 + (t3 - 2 * t2 + t) * dt * v0 +
+           (-2 * t3 + 3 * t2) * p1 + (t3 - t2) * dt * v1;
+  };
+  auto lerp = [&](double a, double b) { return a + t * (b - a); };
+
+  Sample result = before;
+  result.timestamp = static_cast<std::int64_t>(std::llround(microseconds));
+  result.position = hermite(before.position, before.velocity, after.position,
+                            after.velocity);
+  result.velocity = lerp(before.velocity, after.velocity);
+  result.reference_position =
+      hermite(before.reference_position, before.reference_velocity,
+              after.reference_position, after.reference_velocity);
+  result.reference_velocity =
+      lerp(before.reference_velocity, after.reference_velocity);
+  result.voltage = lerp(before.voltage, after.voltage);
+  return result;
+}
+
+PresentationClock::PresentationClock(Time delay) : delay_(delay) {}
+
+Time PresentationClock::Advance(Time elapsed, Time newest) {
+  Time target = newest - delay_;
+  if (!time_ || au::abs(target - *time_) > kMaxCorrection) {
+    time_ = target;
+    return *time_;
+  }
+
+  *time_ += elapsed;
+  double fraction = std::min(1.0, kCorrectionRate * elapsed.in(au::seconds));
+  *time_ += fraction * (target - *time_);
+  // NOTE(hayden): Without new samples, the target stops while the clock runs
+  // on, so the clock waits at the newest sample rather than drift away
+  time_ = std::min(*time_, newest);
+  return *time_;
+}
+
+}  // namespace reefscape
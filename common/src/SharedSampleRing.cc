@@ -0,0 +1,227 @@
+#include "SharedSampleRing.hh"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+namespace reefscape {
+
+namespace {
+
+// "REEFRNG" followed by the layout version
+constexpr std::uint64_t kMagic = 0x52454546524e4701;
+
+// Left by a writer that has shut down or been replaced
+constexpr std::uint64_t kRetired = 0x52454546524e47ff;
+
+}  // namespace
+
+SharedSampleRing::SharedSampleRing(const std::string &name, bool writer)
+    : name_(name), writer_(writer) {
+  if (!writer_) {
+    Attach(false);
+    return;
+  }
+
+  // NOTE(hayden): Replacing the segment rather than reusing it keeps this
+  // run's readers from seeing the last run's samples
+  Retire(name_);
+
+  int fd = ::shm_open(name_.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd < 0) {
+    throw std::system_error(errno, std::generic_category(), name_);
+  }
+
+  // A new segment is zero-filled, so the head and every slot start empty
+  if (::ftruncate(fd, sizeof(Layout)) != 0) {
+    int error = errno;
+    ::close(fd);
+    ::shm_unlink(name_.c_str());
+    throw std::system_error(error, std::generic_category(), name_);
+  }
+
+  void *mapping = ::mmap(nullptr, sizeof(Layout), PROT_READ | PROT_WRITE,
+                         MAP_SHARED, fd, 0);
+  int error = errno;
+  ::close(fd);
+  if (mapping == MAP_FAILED) {
+    ::shm_unlink(name_.c_str());
+    throw std::system_error(error, std::generic_category(), name_);
+  }
+  layout_ = static_cast<Layout *>(mapping);
+  layout_->magic.store(kMagic, std::memory_order_release);
+}
+
+SharedSampleRing::~SharedSampleRing() {
+  if (layout_ == nullptr) {
+    return;
+  }
+
+  if (writer_) {
+    layout_->magic.store(kRetired, std::memory_order_release);
+  }
+  ::munmap(layout_, sizeof(Layout));
+  if (writer_) {
+    ::shm_unlink(name_.c_str());
+  }
+}
+
+SharedSampleRing::Layout *SharedSampleRing::Open(const std::string &name) {
+  int fd = ::shm_open(name.c_str(), O_RDWR, 0);
+  if (fd < 0) {
+    if (errno == ENOENT) {
+      return nullptr;
+    }
+    throw std::system_error(errno, std::generic_category(), name);
+  }
+
+  // NOTE(hayden): A segment smaller than the layout is either still being
+  // sized by its writer or from an incompatible one; neither can be mapped
+  struct stat status;
+  if (::fstat(fd, &status) != 0 ||
+      status.st_size < static_cast<off_t>(sizeof(Layout))) {
+    ::close(fd);
+    return nullptr;
+  }
+
+  void *mapping = ::mmap(nullptr, sizeof(Layout), PROT_READ | PROT_WRITE,
+                         MAP_SHARED, fd, 0);
+  int error = errno;
+  ::close(fd);
+  if (mapping == MAP_FAILED) {
+    throw std::system_error(error, std::generic_category(), name);
+  }
+  return static_cast<Layout *>(mapping);
+}
+
+void SharedSampleRing::Retire(const std::string &name) {
+  // NOTE(hayden): Readers still attached to an unlinked segment would
+  // otherwise wait on it forever, e.g. after the previous writer crashed
+  if (Layout *layout = Open(name)) {
+    layout->magic.store(kRetired, std::memory_order_release);
+    ::munmap(layout, sizeof(Layout));
+  }
+  ::shm_unlink(name.c_str());
+}
+
+bool SharedSampleRing::Attach(bool from_start) {
+  if (layout_ != nullptr) {
+    if (layout_->magic.load(std::memory_order_acquire) != kRetired) {
+      return true;
+    }
+    ::munmap(layout_, sizeof(Layout));
+    layout_ = nullptr;
+  }
+
+  layout_ = Open(name_);
+  if (layout_ == nullptr) {
+    return false;
+  }
+
+  std::uint64_t magic = layout_->magic.load(std::memory_order_acquire);
+  // A zero magic means the writer hasn't finished creating the segment
+  if (magic == 0 || magic == kMagic) {
+    cursor_ =
+        from_start ? 0 : layout_->head.load(std::memory_order_acquire);
+    return true;
+  }
+
+  ::munmap(layout_, sizeof(Layout));
+  layout_ = nullptr;
+  if (magic == kRetired) {
+    return false;
+  }
+  throw std::runtime_error(name_ + ": incompatible sample ring");
+}
+
+void SharedSampleRing::Write(const Sample &sample) {
+  std::uint64_t index = layout_->head.load(std::memory_order_relaxed);
+  Slot &slot = layout_->slots[index % kCapacity];
+
+  slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  std::uint64_t words[kWords];
+  std::memcpy(words, &sample, sizeof(Sample));
+  for (std::size_t i = 0; i < kWords; ++i) {
+    slot.words[i].store(words[i], std::memory_order_relaxed);
+  }
+
+  slot.sequence.store(2 * (index + 1), std::memory_order_release);
+  layout_->head.store(index + 1, std::memory_order_release);
+}
+
+std::optional<Sample> SharedSampleRing::Latest() const {
+  if (layout_ == nullptr) {
+    return std::nullopt;
+  }
+
+  Sample sample;
+  // NOTE(hayden): A read only fails if the writer laps the ring mid-read, so
+  // retrying with the new head terminates almost immediately
+  for (int attempt = 0; attempt < 8; ++attempt) {
+    std::uint64_t head = layout_->head.load(std::memory_order_acquire);
+    if (head == 0) {
+      return std::nullopt;
+    }
+    if (TryRead(head - 1, sample)) {
+      return sample;
+    }
+  }
+  return std::nullopt;
+}
+
+void SharedSampleRing::Read(std::vector<Sample> &samples) {
+  // NOTE(hayden): Once the writer (re)starts, everything it has written
+  // belongs to the run this reader was waiting for
+  if (!Attach(true)) {
+    return;
+  }
+
+  std::uint64_t head = layout_->head.load(std::memory_order_acquire);
+  if (head < cursor_) {
+    cursor_ = head;
+  }
+  if (head - cursor_ > kCapacity) {
+    missed_ += head - cursor_ - kCapacity;
+    cursor_ = head - kCapacity;
+  }
+
+  for (; cursor_ < head; ++cursor_) {
+    if (TryRead(cursor_, samples.emplace_back())) {
+      continue;
+    }
+    samples.pop_back();
+    ++missed_;
+  }
+}
+
+bool SharedSampleRing::TryRead(std::uint64_t index, Sample &sample) const {
+  const Slot &slot = layout_->slots[index % kCapacity];
+  std::uint64_t complete = 2 * (index + 1);
+
+  if (slot.sequence.load(std::memory_order_acquire) != complete) {
+    return false;
+  }
+
+  std::uint64_t words[kWords];
+  for (std::size_t i = 0; i < kWords; ++i) {
+    words[i] = slot.words[i].load(std::memory_order_relaxed);
+  }
+
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (slot.sequence.load(std::memory_order_relaxed) != complete) {
+    return false;
+  }
+
+  std::memcpy(&sample, words, sizeof(Sample));
+  return true;
+}
+
+}  // namespace reefscape
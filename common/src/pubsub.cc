@@ -1,84 +1,117 @@
 #include "pubsub.hh"
 
-#include "input.hh"
+#include <cstdint>
+#include <cstring>
+#include <span>
+
 #include "ntcore_cpp.h"
 #include "robot.hh"
-#include "state.hh"
-#include "units.hh"
+#include "sample.hh"
 
 namespace reefscape {
 
 Publisher::Publisher(NT_Inst instance) {
   this->instance = instance;
 
-  position = nt::Publish(nt::GetTopic(instance, kElevatorPositionKey),
-                         NT_DOUBLE, "double");
-  velocity = nt::Publish(nt::GetTopic(instance, kElevatorVelocityKey),
-                         NT_DOUBLE, "double");
-  reference_position =
-      nt::Publish(nt::GetTopic(instance, kElevatorReferencePositionKey),
-                  NT_DOUBLE, "double");
-  reference_velocity =
-      nt::Publish(nt::GetTopic(instance, kElevatorReferenceVelocityKey),
-                  NT_DOUBLE, "double");
-  voltage = nt::Publish(nt::GetTopic(instance, kElevatorVoltageKey), NT_DOUBLE,
-                        "double");
-  at_goal = nt::Publish(nt::GetTopic(instance, kElevatorAtGoalKey), NT_BOOLEAN,
-                        "boolean");
+  nt::AddSchema(instance, kSampleTypeString, "structschema", kSampleSchema);
+  // NOTE(hayden): By default NT only sends the latest value at each flush,
+  // which would drop ticks for queued subscribers
+  nt::PubSubOptions options;
+  options.sendAll = true;
+  sample = nt::Publish(nt::GetTopic(instance, kElevatorSampleKey), NT_RAW,
+                       kSampleTypeString, options);
+}
+
+Publisher::Publisher(NT_Inst instance, const std::string &shm_name)
+    : Publisher(instance) {
+  ring = std::make_unique<SharedSampleRing>(shm_name, true);
 }
 
-void Publisher::Publish(PositionVelocityState state,
-                        PositionVelocityState reference, VoltageInput input,
-                        bool at_goal) const {
-  nt::SetDouble(position, state.Position().in(au::meters));
-  nt::SetDouble(velocity, state.Velocity().in(au::meters / au::second));
-  nt::SetDouble(reference_position, reference.Position().in(au::meters));
-  nt::SetDouble(reference_velocity,
-                reference.Velocity().in(au::meters / au::second));
-  nt::SetDouble(voltage, input.Voltage().in(au::volts));
-  nt::SetBoolean(this->at_goal, at_goal);
+void Publisher::Publish(const Sample &sample) const {
+  if (ring) {
+    ring->Write(sample);
+  }
+  Send(sample);
   nt::Flush(instance);
 }
 
-Subscriber::Subscriber(NT_Inst instance) {
+void Publisher::Send(const Sample &sample) const {
+  nt::SetRaw(this->sample,
+             std::span{reinterpret_cast<const std::uint8_t *>(&sample),
+                       sizeof(Sample)});
+}
+
+Subscriber::Subscriber(NT_Inst instance, std::size_t queue_size) {
   this->instance = instance;
 
-  position = nt::Subscribe(nt::GetTopic(instance, kElevatorPositionKey),
-                           NT_DOUBLE, "double");
-  velocity = nt::Subscribe(nt::GetTopic(instance, kElevatorVelocityKey),
-                           NT_DOUBLE, "double");
-  reference_position =
-      nt::Subscribe(nt::GetTopic(instance, kElevatorReferencePositionKey),
-                    NT_DOUBLE, "double");
-  reference_velocity =
-      nt::Subscribe(nt::GetTopic(instance, kElevatorReferenceVelocityKey),
-                    NT_DOUBLE, "double");
-  voltage = nt::Subscribe(nt::GetTopic(instance, kElevatorVoltageKey),
-                          NT_DOUBLE, "double");
-  at_goal = nt::Subscribe(nt::GetTopic(instance, kElevatorAtGoalKey),
-                          NT_BOOLEAN, "boolean");
+  nt::PubSubOptions options;
+  if (queue_size > 0) {
+    options.pollStorage = static_cast<unsigned int>(queue_size);
+    options.sendAll = true;
+  }
+  sample = nt::Subscribe(nt::GetTopic(instance, kElevatorSampleKey), NT_RAW,
+                         kSampleTypeString, options);
 }
 
-Displacement Subscriber::Position() const {
-  return au::meters(nt::GetDouble(position, 0.0));
+Subscriber::Subscriber(const std::string &shm_name)
+    : ring(std::make_unique<SharedSampleRing>(shm_name, false)) {
+  ring_samples.reserve(SharedSampleRing::kCapacity);
 }
 
-LinearVelocity Subscriber::Velocity() const {
-  return (au::meters / au::second)(nt::GetDouble(velocity, 0.0));
+Sample Subscriber::Latest() const {
+  if (ring) {
+    return ring->Latest().value_or(Sample{});
+  }
+
+  Sample result{};
+  auto value = nt::GetRaw(sample, {});
+  // NOTE(hayden): Anything but a whole sample is from an incompatible
+  // publisher and is ignored
+  if (value.size() == sizeof(Sample)) {
+    std::memcpy(&result, value.data(), sizeof(Sample));
+  }
+  return result;
 }
 
-Displacement Subscriber::ReferencePosition() const {
-  return au::meters(nt::GetDouble(reference_position, 0.0));
+void Subscriber::Drain(std::vector<TimestampedSample> &samples) {
+  samples.clear();
+
+  if (ring) {
+    ring_samples.clear();
+    ring->Read(ring_samples);
+    auto now = nt::Now();
+    for (const Sample &sample : ring_samples) {
+      samples.push_back({now, sample});
+    }
+    return;
+  }
+
+  for (const auto &value : nt::ReadQueueRaw(sample)) {
+    if (value.value.size() != sizeof(Sample)) {
+      continue;
+    }
+    auto &received = samples.emplace_back();
+    received.time = value.time;
+    std::memcpy(&received.sample, value.value.data(), sizeof(Sample));
+  }
 }
 
-LinearVelocity Subscriber::ReferenceVelocity() const {
-  return (au::meters / au::second)(nt::GetDouble(reference_velocity, 0.0));
+EnsemblePublisher::EnsemblePublisher(NT_Inst instance) {
+  position = nt::Publish(nt::GetTopic(instance, kEnsemblePositionKey),
+                         NT_DOUBLE_ARRAY, "double[]");
 }
 
-Voltage Subscriber::Voltage() const {
-  return au::volts(nt::GetDouble(voltage, 0.0));
+void EnsemblePublisher::Publish(std::span<const double> positions) const {
+  nt::SetDoubleArray(position, positions);
 }
 
-bool Subscriber::AtGoal() const { return nt::GetBoolean(at_goal, false); }
+EnsembleSubscriber::EnsembleSubscriber(NT_Inst instance) {
+  position = nt::Subscribe(nt::GetTopic(instance, kEnsemblePositionKey),
+                           NT_DOUBLE_ARRAY, "double[]");
+}
+
+std::vector<double> EnsembleSubscriber::Latest() const {
+  return nt::GetDoubleArray(position, {});
+}
 
 };  // namespace reefscape
@@ -0,0 +1,244 @@
+#include "telemetry.hh"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+
+#include "raylib.h"
+
+namespace reefscape {
+
+TelemetryRecorder::TelemetryRecorder(const std::string &path,
+                                     std::size_t capacity)
+    : file_(std::fopen(path.c_str(), "wb")), queue_(capacity) {
+  if (file_ == nullptr) {
+    throw std::system_error(errno, std::generic_category(), path);
+  }
+
+  TelemetryHeader header{};
+  std::memcpy(header.magic, TelemetryHeader::kMagic, sizeof(header.magic));
+  header.version = TelemetryHeader::kVersion;
+  header.record_size = sizeof(Sample);
+  if (std::fwrite(&header, sizeof(header), 1, file_) != 1 ||
+      std::fflush(file_) != 0) {
+    int error = errno;
+    std::fclose(file_);
+    throw std::system_error(error, std::generic_category(), path);
+  }
+
+  writer_ = std::jthread{
+      [this](std::stop_token stop_token) { Write(stop_token); }};
+}
+
+TelemetryRecorder::~TelemetryRecorder() {
+  writer_.request_stop();
+  writer_.join();
+  std::fclose(file_);
+}
+
+void TelemetryRecorder::Write(std::stop_token stop_token) {
+  while (!stop_token.stop_requested()) {
+    if (Drain() == 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+
+  // NOTE(hayden): The producer may have queued more after the stop request
+  while (Drain() != 0) {
+  }
+}
+
+std::size_t TelemetryRecorder::Drain() {
+  std::array<Sample, 256> batch;
+  std::size_t total = 0;
+
+  std::size_t count;
+  do {
+    count = 0;
+    while (count < batch.size()) {
+      auto sample = queue_.TryPop();
+      if (!sample) {
+        break;
+      }
+      batch[count++] = *sample;
+    }
+    std::size_t written = std::fwrite(batch.data(), sizeof(Sample), count,
+                                      file_);
+    if (written != count) {
+      // NOTE(hayden): Unwritten samples are counted as dropped, but only the
+      // first failure is reported so a full disk doesn't flood the console
+      dropped_.fetch_add(count - written, std::memory_order_relaxed);
+      if (!write_failed_) {
+        std::cerr << "telemetry: write failed: " << std::strerror(errno)
+                  << std::endl;
+        write_failed_ = true;
+      }
+      std::clearerr(file_);
+    }
+    total += count;
+  } while (count == batch.size());
+
+  // Flush so that a reader mapping the log sees whole records promptly
+  if (total != 0) {
+    std::fflush(file_);
+  }
+  return total;
+}
+
+TelemetryLog::TelemetryLog(const std::string &path) {
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::system_error(errno, std::generic_category(), path);
+  }
+
+  struct stat status;
+  if (::fstat(fd, &status) != 0) {
+    int fstat_error = errno;
+    ::close(fd);
+    throw std::system_error(fstat_error, std::generic_category(), path);
+  }
+  mapping_length_ = static_cast<std::size_t>(status.st_size);
+  if (mapping_length_ < sizeof(TelemetryHeader)) {
+    ::close(fd);
+    throw std::runtime_error(path + ": not a telemetry log");
+  }
+
+  mapping_ = ::mmap(nullptr, mapping_length_, PROT_READ, MAP_PRIVATE, fd, 0);
+  int error = errno;
+  // NOTE(hayden): The mapping stays valid after the descriptor is closed
+  ::close(fd);
+  if (mapping_ == MAP_FAILED) {
+    mapping_ = nullptr;
+    throw std::system_error(error, std::generic_category(), path);
+  }
+
+  const auto *header = static_cast<const TelemetryHeader *>(mapping_);
+  if (std::memcmp(header->magic, TelemetryHeader::kMagic,
+                  sizeof(header->magic)) != 0 ||
+      header->version != TelemetryHeader::kVersion ||
+      header->record_size != sizeof(Sample)) {
+    ::munmap(mapping_, mapping_length_);
+    throw std::runtime_error(path + ": unsupported telemetry log");
+  }
+
+  // Playback reads records in order, so let the kernel read ahead
+  ::madvise(mapping_, mapping_length_, MADV_SEQUENTIAL);
+
+  samples_ = reinterpret_cast<const Sample *>(
+      static_cast<const char *>(mapping_) + sizeof(TelemetryHeader));
+  size_ = (mapping_length_ - sizeof(TelemetryHeader)) / sizeof(Sample);
+}
+
+TelemetryLog::~TelemetryLog() {
+  if (mapping_ != nullptr) {
+    ::munmap(mapping_, mapping_length_);
+  }
+}
+
+std::size_t TelemetryLog::Seek(quantities::Time time) const {
+  double timestamp = time.in(au::micro(au::seconds));
+  auto samples = Samples();
+  auto it = std::ranges::partition_point(samples, [=](const Sample &sample) {
+    return sample.timestamp < timestamp;
+  });
+  return static_cast<std::size_t>(it - samples.begin());
+}
+
+quantities::Time TelemetryLog::StartTime() const {
+  return Empty() ? au::seconds(0) : samples_[0].Time();
+}
+
+quantities::Time TelemetryLog::EndTime() const {
+  return Empty() ? au::seconds(0) : samples_[size_ - 1].Time();
+}
+
+TelemetryPlayer::TelemetryPlayer(const TelemetryLog &log, double speed)
+    : log_(log), speed_(speed), time_(log.StartTime()) {
+  cursor_ = Cursor();
+}
+
+std::span<const Sample> TelemetryPlayer::Advance(quantities::Time elapsed) {
+  time_ = std::min(time_ + speed_ * elapsed, log_.EndTime());
+
+  std::size_t begin = cursor_;
+  cursor_ = std::max(Cursor(), begin);
+  return log_.Samples().subspan(begin, cursor_ - begin);
+}
+
+void TelemetryPlayer::Seek(quantities::Time time) {
+  time_ = std::clamp(time, log_.StartTime(), log_.EndTime());
+  cursor_ = Cursor();
+}
+
+Sample TelemetryPlayer::Current() const {
+  if (log_.Empty()) {
+    return {};
+  }
+  return log_[cursor_ == 0 ? 0 : cursor_ - 1];
+}
+
+std::size_t TelemetryPlayer::Cursor() const {
+  double timestamp = time_.in(au::micro(au::seconds));
+  auto samples = log_.Samples();
+  auto it = std::ranges::partition_point(samples, [=](const Sample &sample) {
+    return sample.timestamp <= timestamp;
+  });
+  return static_cast<std::size_t>(it - samples.begin());
+}
+
+const char *const kViewerUsage =
+    "[--replay FILE [--speed FACTOR] | --shm NAME] [--trace FILE]";
+
+bool ParseViewerOption(int argc, char *argv[], int &i,
+                       ViewerOptions &options) {
+  std::string_view arg = argv[i];
+  if (i + 1 >= argc) {
+    return false;
+  }
+  if (arg == "--replay") {
+    options.replay = argv[++i];
+  } else if (arg == "--speed") {
+    options.speed = std::atof(argv[++i]);
+  } else if (arg == "--shm") {
+    options.shm = argv[++i];
+  } else if (arg == "--trace") {
+    options.trace = argv[++i];
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool HandleReplayKeys(TelemetryPlayer &player) {
+  const quantities::Time seek_step = au::seconds(5);
+  bool seeked = false;
+  if (IsKeyPressed(KEY_LEFT_BRACKET)) {
+    player.Seek(player.Time() - seek_step);
+    seeked = true;
+  }
+  if (IsKeyPressed(KEY_RIGHT_BRACKET)) {
+    player.Seek(player.Time() + seek_step);
+    seeked = true;
+  }
+  if (IsKeyPressed(KEY_MINUS)) {
+    player.SetSpeed(player.Speed() / 2);
+  }
+  if (IsKeyPressed(KEY_EQUAL)) {
+    player.SetSpeed(player.Speed() * 2);
+  }
+  return seeked;
+}
+
+}  // namespace reefscape
@@ -0,0 +1,203 @@
+#include "trace.hh"
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace reefscape::trace {
+
+namespace internal {
+
+std::atomic<bool> enabled = false;
+
+}  // namespace internal
+
+namespace {
+
+struct Event {
+  const char *name;
+  std::int64_t timestamp;
+  double value;
+  char phase;
+};
+
+// NOTE(hayden): Events are allocated a chunk at a time as the buffer fills, so
+// a thread that records little never touches (or, under mlockall, locks) the
+// memory for a full buffer
+constexpr std::size_t kChunkSize = 4096;
+
+struct ThreadBuffer {
+  explicit ThreadBuffer(std::size_t capacity)
+      : capacity(capacity),
+        chunks((capacity + kChunkSize - 1) / kChunkSize) {}
+
+  Event &operator[](std::size_t index) {
+    return chunks[index / kChunkSize][index % kChunkSize];
+  }
+
+  std::size_t capacity;
+  // Chunks are only ever added, so filled events never move
+  std::vector<std::unique_ptr<Event[]>> chunks;
+  // NOTE(hayden): Only the owning thread appends; Stop() reads up to `size`,
+  // which is published after each event is complete
+  std::atomic<std::size_t> size = 0;
+  std::atomic<std::size_t> dropped = 0;
+  pid_t thread_id = gettid();
+};
+
+struct Tracer {
+  std::mutex mutex;
+  // Buffers are never freed, so a thread may exit while its events wait
+  std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+  std::string path;
+  std::string process_name;
+  std::size_t capacity = 0;
+};
+
+Tracer &GetTracer() {
+  static Tracer tracer;
+  return tracer;
+}
+
+thread_local ThreadBuffer *local_buffer = nullptr;
+
+ThreadBuffer &LocalBuffer() {
+  if (local_buffer == nullptr) {
+    Tracer &tracer = GetTracer();
+    std::lock_guard lock{tracer.mutex};
+    tracer.buffers.push_back(std::make_unique<ThreadBuffer>(tracer.capacity));
+    local_buffer = tracer.buffers.back().get();
+  }
+  return *local_buffer;
+}
+
+std::int64_t Now() {
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1'000'000'000 + now.tv_nsec;
+}
+
+void AppendEvent(std::string &json, const Event &event, pid_t process_id,
+                 pid_t thread_id) {
+  char line[256];
+  double microseconds = event.timestamp / 1e3;
+  if (event.phase == 'C') {
+    std::snprintf(line, sizeof(line),
+                  "{\"name\":\"%s\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":%d,"
+                  "\"args\":{\"value\":%.9g}},\n",
+                  event.name, microseconds, process_id, event.value);
+  } else {
+    std::snprintf(line, sizeof(line),
+                  "{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":%d,"
+                  "\"tid\":%d},\n",
+                  event.name, event.phase, microseconds, process_id,
+                  thread_id);
+  }
+  json += line;
+}
+
+}  // namespace
+
+namespace internal {
+
+void Append(const char *name, char phase, double value) {
+  ThreadBuffer &buffer = LocalBuffer();
+  std::size_t size = buffer.size.load(std::memory_order_relaxed);
+  if (size == buffer.capacity) {
+    buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  auto &chunk = buffer.chunks[size / kChunkSize];
+  if (!chunk) {
+    chunk = std::make_unique_for_overwrite<Event[]>(kChunkSize);
+  }
+  buffer[size] = {name, Now(), value, phase};
+  buffer.size.store(size + 1, std::memory_order_release);
+}
+
+}  // namespace internal
+
+void Start(const std::string &path, std::string_view process_name,
+           std::size_t capacity) {
+  Tracer &tracer = GetTracer();
+  {
+    std::lock_guard lock{tracer.mutex};
+    tracer.path = path;
+    tracer.process_name = process_name;
+    tracer.capacity = capacity;
+  }
+  internal::enabled.store(true, std::memory_order_relaxed);
+}
+
+void Stop() {
+  if (!internal::enabled.exchange(false)) {
+    return;
+  }
+
+  Tracer &tracer = GetTracer();
+  std::lock_guard lock{tracer.mutex};
+
+  pid_t process_id = getpid();
+  std::string json = "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" +
+                     std::to_string(process_id) + ",\"args\":{\"name\":\"" +
+                     tracer.process_name + "\"}},\n";
+  std::size_t dropped = 0;
+  for (const auto &buffer : tracer.buffers) {
+    std::size_t size = buffer->size.load(std::memory_order_acquire);
+    for (std::size_t i = 0; i < size; ++i) {
+      AppendEvent(json, (*buffer)[i], process_id, buffer->thread_id);
+    }
+    dropped += buffer->dropped.load(std::memory_order_relaxed);
+  }
+
+  int fd = ::open(tracer.path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+  if (fd < 0) {
+    std::cerr << "warning: " << tracer.path << ": " << std::strerror(errno)
+              << std::endl;
+    return;
+  }
+
+  // NOTE(hayden): The JSON array format allows the closing bracket and a
+  // trailing comma to be omitted, so each process appends its events whole
+  // and whichever finds the file empty opens the array
+  ::flock(fd, LOCK_EX);
+  struct stat status;
+  if (::fstat(fd, &status) == 0 && status.st_size == 0) {
+    json.insert(0, "[\n");
+  }
+  std::size_t written = 0;
+  while (written < json.size()) {
+    ssize_t result =
+        ::write(fd, json.data() + written, json.size() - written);
+    if (result < 0 && errno == EINTR) {
+      continue;
+    }
+    if (result <= 0) {
+      std::cerr << "warning: " << tracer.path << ": " << std::strerror(errno)
+                << std::endl;
+      break;
+    }
+    written += static_cast<std::size_t>(result);
+  }
+  ::flock(fd, LOCK_UN);
+  ::close(fd);
+
+  if (dropped != 0) {
+    std::cerr << "warning: " << dropped << " trace events dropped"
+              << std::endl;
+  }
+}
+
+}  // namespace reefscape::trace
@@ -0,0 +1,22 @@
+#pragma once
+
+namespace reefscape {
+
+// GLSL for `vec3 VoltageColor(float voltage)`, shared by the shaders that
+// color by voltage. Warm hues while driving up and cool hues while driving
+// down, shifting further with more voltage.
+inline constexpr const char *kVoltageColor = R"(
+vec3 HSVToRGB(vec3 hsv) {
+  vec3 k = mod(vec3(5.0, 3.0, 1.0) + hsv.x * 6.0, 6.0);
+  return hsv.z - hsv.z * hsv.y * clamp(min(k, 4.0 - k), 0.0, 1.0);
+}
+
+vec3 VoltageColor(float voltage) {
+  float hue = voltage < 0.0
+                  ? mix(180.0, 210.0, clamp(voltage, -12.0, 0.0) / 12.0 + 1.0)
+                  : mix(0.0, 30.0, clamp(voltage, 0.0, 12.0) / 12.0);
+  return HSVToRGB(vec3(hue / 360.0, 0.75, 1.0));
+}
+)";
+
+}  // namespace reefscape
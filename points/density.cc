@@ -0,0 +1,164 @@
+#include "density.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+#include "color.hh"
+#include "raymath.h"
+#include "rlgl.h"
+
+namespace reefscape {
+
+namespace {
+
+const char *const kFragmentShader = R"(
+in vec2 fragTexCoord;
+
+uniform sampler2D texture0;
+uniform float maxDensity;
+
+out vec4 finalColor;
+
+void main() {
+  vec3 bin = texture(texture0, fragTexCoord).rgb;
+  if (bin.r == 0.0) {
+    discard;
+  }
+
+  float density = bin.r / maxDensity;
+  finalColor = vec4(VoltageColor(bin.g), mix(0.15, 1.0, density));
+}
+)";
+
+// Each texel holds a bin's density, its mean voltage, and an unused channel
+constexpr int kChannels = 3;
+
+// NOTE(hayden): Counts span orders of magnitude between a dwell and a pass,
+// so they are shaded logarithmically
+float Density(std::uint32_t count) {
+  return static_cast<float>(std::log1p(static_cast<double>(count)));
+}
+
+}  // namespace
+
+DensityMap::DensityMap(int width, int height, Vector2 min, Vector2 max)
+    : width_(width),
+      height_(height),
+      min_(min),
+      max_(max),
+      counts_(width * height),
+      voltage_sums_(width * height),
+      staging_(width * height * kChannels) {
+  Image image{staging_.data(), width_, height_, 1,
+              PIXELFORMAT_UNCOMPRESSED_R32G32B32};
+  texture_ = LoadTextureFromImage(image);
+  dirty_min_x_ = width_;
+  dirty_max_x_ = 0;
+  dirty_min_y_ = height_;
+  dirty_max_y_ = 0;
+
+  mesh_ = GenMeshPlane(max.x - min.x, max.y - min.y, 1, 1);
+  material_ = LoadMaterialDefault();
+  std::string fragment_shader =
+      std::string{"#version 330\n"} + kVoltageColor + kFragmentShader;
+  material_.shader = LoadShaderFromMemory(nullptr, fragment_shader.c_str());
+  material_.maps[MATERIAL_MAP_DIFFUSE].texture = texture_;
+  max_density_location_ = GetShaderLocation(material_.shader, "maxDensity");
+}
+
+DensityMap::~DensityMap() {
+  // NOTE(hayden): The material does not own the texture, so it is detached
+  // to keep UnloadMaterial from freeing it twice
+  material_.maps[MATERIAL_MAP_DIFFUSE].texture = Texture2D{};
+  UnloadMaterial(material_);
+  UnloadTexture(texture_);
+  UnloadMesh(mesh_);
+}
+
+void DensityMap::Clear() {
+  std::fill(counts_.begin(), counts_.end(), 0);
+  std::fill(voltage_sums_.begin(), voltage_sums_.end(), 0.0);
+  max_count_ = 0;
+  outside_ = 0;
+  Invalidate();
+}
+
+void DensityMap::Invalidate() {
+  dirty_min_x_ = 0;
+  dirty_max_x_ = width_;
+  dirty_min_y_ = 0;
+  dirty_max_y_ = height_;
+}
+
+void DensityMap::Add(float x, float z, float voltage) {
+  // NOTE(hayden): Written so that NaN fails the test, since converting it to
+  // an int is undefined
+  if (!(x >= min_.x && x <= max_.x && z >= min_.y && z <= max_.y)) {
+    ++outside_;
+    return;
+  }
+
+  // The bounds are inclusive, so a point on the upper edge joins the last bin
+  int column = std::min(
+      static_cast<int>((x - min_.x) / (max_.x - min_.x) * width_), width_ - 1);
+  int row = std::min(
+      static_cast<int>((z - min_.y) / (max_.y - min_.y) * height_),
+      height_ - 1);
+
+  int bin = row * width_ + column;
+  ++counts_[bin];
+  voltage_sums_[bin] += voltage;
+  max_count_ = std::max(max_count_, counts_[bin]);
+
+  dirty_min_x_ = std::min(dirty_min_x_, column);
+  dirty_max_x_ = std::max(dirty_max_x_, column + 1);
+  dirty_min_y_ = std::min(dirty_min_y_, row);
+  dirty_max_y_ = std::max(dirty_max_y_, row + 1);
+}
+
+void DensityMap::Draw() {
+  if (dirty_min_x_ < dirty_max_x_) {
+    int columns = dirty_max_x_ - dirty_min_x_;
+    int rows = dirty_max_y_ - dirty_min_y_;
+    float *texel = staging_.data();
+    for (int row = 0; row < rows; ++row) {
+      int bin = (dirty_min_y_ + row) * width_ + dirty_min_x_;
+      for (int column = 0; column < columns; ++column, ++bin) {
+        std::uint32_t count = counts_[bin];
+        texel[0] = Density(count);
+        texel[1] = count == 0 ? 0.0f
+                              : static_cast<float>(voltage_sums_[bin] / count);
+        texel[2] = 0;
+        texel += kChannels;
+      }
+    }
+    Rectangle dirty{static_cast<float>(dirty_min_x_),
+                    static_cast<float>(dirty_min_y_),
+                    static_cast<float>(columns), static_cast<float>(rows)};
+    UpdateTextureRec(texture_, dirty, staging_.data());
+
+    dirty_min_x_ = width_;
+    dirty_max_x_ = 0;
+    dirty_min_y_ = height_;
+    dirty_max_y_ = 0;
+  }
+
+  if (max_count_ == 0) {
+    return;
+  }
+
+  float max_density = Density(max_count_);
+  SetShaderValue(material_.shader, max_density_location_, &max_density,
+                 SHADER_UNIFORM_FLOAT);
+
+  // NOTE(hayden): The plane faces up, but the camera may be below it, so it is
+  // drawn from both sides
+  Matrix transform =
+      MatrixTranslate((min_.x + max_.x) / 2, 0, (min_.y + max_.y) / 2);
+  rlDisableBackfaceCulling();
+  DrawMesh(mesh_, material_, transform);
+  rlEnableBackfaceCulling();
+}
+
+}  // namespace reefscape
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "raylib.h"
+
+namespace reefscape {
+
+// A histogram of every point in the (x, z) plane, drawn as a texture in that
+// plane. Each bin is shaded by how often it was visited, relative to the most
+// visited bin, and colored by the mean voltage there.
+//
+// Adding a point updates a single bin, and only the bins changed since the
+// last draw are uploaded, so the cost of drawing does not grow with the
+// number of points.
+class DensityMap {
+ public:
+  // Bins `x` from `min.x` to `max.x` and `z` from `min.y` to `max.y`
+  DensityMap(int width, int height, Vector2 min, Vector2 max);
+
+  DensityMap(const DensityMap &) = delete;
+  DensityMap &operator=(const DensityMap &) = delete;
+
+  ~DensityMap();
+
+  // Empties every bin
+  void Clear();
+
+  // Counts a point at `x` and `z`, if within the bounds (inclusive), with
+  // `voltage` in volts
+  void Add(float x, float z, float voltage);
+
+  // Number of points outside of the bounds
+  std::uint64_t Outside() const { return outside_; }
+
+  // Uploads changed bins and draws the map at y = 0. Must be called in 3D
+  // mode.
+  void Draw();
+
+ private:
+  // Marks every bin as changed
+  void Invalidate();
+
+  int width_;
+  int height_;
+  Vector2 min_;
+  Vector2 max_;
+
+  std::vector<std::uint32_t> counts_;
+  // Sum of the voltages of every point in each bin
+  std::vector<double> voltage_sums_;
+  std::uint32_t max_count_ = 0;
+  std::uint64_t outside_ = 0;
+
+  // Bins changed since the last upload, as a half-open rectangle; empty if
+  // `dirty_min_x_ >= dirty_max_x_`
+  int dirty_min_x_;
+  int dirty_max_x_;
+  int dirty_min_y_;
+  int dirty_max_y_;
+  // Density and mean voltage of the changed bins, packed for upload
+  std::vector<float> staging_;
+
+  Texture2D texture_{};
+  Mesh mesh_{};
+  Material material_{};
+  int max_density_location_;
+};
+
+}  // namespace reefscape
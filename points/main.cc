@@ -1,81 +1,107 @@
-#include <deque>
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <vector>
 
+#include "density.hh"
 #include "ntcore_cpp.h"
 #include "pubsub.hh"
+#include "pyramid.hh"
 #include "raylib.h"
-#include "raymath.h"
-#include "rlgl.h"
+#include "robot.hh"
+#include "sample.hh"
+#include "telemetry.hh"
+#include "trace.hh"
 #include "units.hh"
 
 using namespace reefscape;
 
-const int buffer_size = 2000;
+// NOTE(hayden): Each level of the history spans kMaxSegments samples times
+// its decimation, so at 1 kHz the finest covers 16 seconds and the coarsest
+// over four hours
+const int segments_per_level = Trail::kMaxSegments;
+const double seconds_per_unit = 4.0;
+// NOTE(hayden): Faster than the elevator can move, so only a fault lands
+// outside of the density map
+const float max_density_velocity = 4.0f;
+const int density_resolution = 256;
 
 struct Point {
-  int tick;
+  Time time;
   Displacement position;
   LinearVelocity velocity;
   Voltage voltage;
 
+  // Position in phase space, in the plane of the grid
   Vector3 Position() const;
-  double Hue() const;
+
+  // Height in phase space, which is the time since `start`
+  double Height(Time start) const;
 };
 
 Vector3 Point::Position() const {
   float position_ = position.in(au::meters);
   float velocity_ = velocity.in(au::meters / au::second);
-  float time = tick / (2.0 * buffer_size);
-  return Vector3{velocity_, time, position_};
+  return Vector3{velocity_, 0, position_};
 }
 
-double map(double in, double in_min, double in_max, double out_min,
-           double out_max) {
-  return ((in - in_min) / (in_max - in_min)) * (out_max - out_min) + out_min;
+double Point::Height(Time start) const {
+  return (time - start).in(au::seconds) / seconds_per_unit;
 }
 
-double Point::Hue() const {
-  if (voltage < au::volts(0)) {
-    return map(clamp(voltage, au::volts(-12), au::volts(0)).in(au::volts), -12,
-               0, 180, 210);
-  } else {
-    return map(clamp(voltage, au::volts(0), au::volts(12)).in(au::volts), 0, 12,
-               0, 30);
-  }
-}
-
-struct PointBuffer {
-  std::deque<Point> points_;
-  unsigned int max_points_;
-
-  PointBuffer(int max_points) : max_points_(max_points) {};
-
-  void push(Point point);
-};
-
-void PointBuffer::push(Point point) {
-  auto size = points_.size();
+ViewerOptions ParseOptions(int argc, char *argv[]) {
+  ViewerOptions options;
 
-  if (size == max_points_) {
-    points_.pop_front();
+  for (int i = 1; i < argc; ++i) {
+    if (!ParseViewerOption(argc, argv, i, options)) {
+      std::cerr << "usage: " << argv[0] << ' ' << kViewerUsage << std::endl;
+      std::exit(EXIT_FAILURE);
+    }
   }
 
-  points_.push_back(point);
+  return options;
 }
 
-int main() {
-  auto client = nt::CreateInstance();
-  nt::StartClient4(client, "client");
-  nt::SetServer(client, "127.0.0.1", 5810);
+int main(int argc, char *argv[]) {
+  ViewerOptions options = ParseOptions(argc, argv);
+  if (!options.trace.empty()) {
+    trace::Start(options.trace, "points");
+  }
 
-  Subscriber subscriber{client};
+  std::optional<TelemetryLog> log;
+  std::optional<TelemetryPlayer> player;
+  std::optional<Subscriber> subscriber;
+  if (!options.replay.empty()) {
+    log.emplace(options.replay);
+    player.emplace(*log, options.speed);
+  } else if (!options.shm.empty()) {
+    subscriber.emplace(options.shm);
+  } else {
+    auto client = nt::CreateInstance();
+    nt::StartClient4(client, "client");
+    nt::SetServer(client, "127.0.0.1", 5810);
+    // NOTE(hayden): Enough for several frames of 1 kHz samples, in case a
+    // frame runs long
+    subscriber.emplace(client, 1024);
+  }
+  std::vector<TimestampedSample> received;
 
   InitWindow(1280, 720, "TODO");
   SetTargetFPS(240);
   DisableCursor();
 
-  PointBuffer points{buffer_size};
+  // NOTE(hayden): GPU resources must be released before the window closes
+  std::optional<TrailPyramid> history;
+  history.emplace(segments_per_level);
+  std::optional<DensityMap> density;
+  density.emplace(density_resolution, density_resolution,
+                  Vector2{-max_density_velocity, 0},
+                  Vector2{max_density_velocity,
+                          static_cast<float>(kTotalTravel.in(au::meters))});
+  // H switches between the recent history and the density of every sample
+  bool show_density = false;
 
-  int tick = 0;
+  std::optional<Time> start;
 
   Camera camera = {0};
   camera.position = Vector3{5, 5, 5};
@@ -87,12 +113,43 @@ int main() {
   CameraMode mode = CAMERA_FIRST_PERSON;
 
   while (!WindowShouldClose()) {
-    auto position = subscriber.Position();
-    auto velocity = subscriber.Velocity();
-    auto voltage = subscriber.Voltage();
-    int tick_ = tick++ % points.max_points_;
-    Point point{tick_, position, velocity, voltage};
-    points.push(point);
+    auto push_sample = [&](const Sample &sample) {
+      Point point{sample.Time(), sample.State().Position(),
+                  sample.State().Velocity(), sample.Voltage()};
+      if (!start) {
+        start = point.time;
+      }
+      Vector3 position = point.Position();
+      history->Push(position.x, point.Height(*start), position.z,
+                    point.voltage.in(au::volts));
+      density->Add(position.x, position.z, point.voltage.in(au::volts));
+    };
+
+    trace::Begin("receive");
+    if (player) {
+      // NOTE(hayden): A seek would otherwise draw a segment across the jump
+      if (HandleReplayKeys(*player)) {
+        history->Clear();
+        density->Clear();
+      }
+      // Every logged tick is drawn, regardless of the playback speed
+      for (const Sample &sample :
+           player->Advance(au::seconds(GetFrameTime()))) {
+        push_sample(sample);
+      }
+    } else {
+      subscriber->Drain(received);
+      for (const auto &timestamped : received) {
+        push_sample(timestamped.sample);
+      }
+    }
+    trace::End("receive");
+    trace::Counter("points", static_cast<double>(history->Size()));
+    trace::Counter("outside", static_cast<double>(density->Outside()));
+
+    if (IsKeyPressed(KEY_H)) {
+      show_density = !show_density;
+    }
 
     if (IsKeyPressed(KEY_SPACE)) {
       if (camera.projection == CAMERA_PERSPECTIVE) {
@@ -114,39 +171,15 @@ int main() {
 
     UpdateCamera(&camera, mode);
 
+    trace::Begin("draw");
     BeginDrawing();
     ClearBackground(RAYWHITE);
     BeginMode3D(camera);
     DrawGrid(10, 1);
-    for (auto it = points.points_.cbegin();
-         std::next(it) != points.points_.end(); ++it) {
-      Point first = *it;
-      Point second = *std::next(it);
-      auto difference = second.tick - first.tick;
-      if (difference != 1) {
-        continue;
-      }
-
-      double hue = first.Hue();
-      Color color = ColorFromHSV(hue, 75, 100);
-
-      Vector3 direction = Vector3Subtract(second.Position(), first.Position());
-      double length = Vector3Length(direction);
-      Vector3 center = Vector3Lerp(first.Position(), second.Position(), 0.5);
-
-      Vector3 up{0, 1, 0};
-      Vector3 axis = Vector3CrossProduct(up, direction);
-      double angle =
-          std::acosf(Vector3DotProduct(Vector3Normalize(direction), up)) *
-          RAD2DEG;
-
-      double thickness = 0.01;
-
-      rlPushMatrix();
-      rlTranslatef(center.x, center.y, center.z);
-      rlRotatef(angle, axis.x, axis.y, axis.z);
-      DrawCylinder((Vector3){0, 0, 0}, thickness, thickness, length, 8, color);
-      rlPopMatrix();
+    if (show_density) {
+      density->Draw();
+    } else {
+      history->Draw(camera, 3.0f);
     }
 
     Vector3 zero{};
@@ -154,10 +187,16 @@ int main() {
     DrawLine3D(zero, {0, 0, 10}, GREEN);
 
     EndMode3D();
+    trace::End("draw");
+
+    trace::Scope end_drawing{"EndDrawing"};
     EndDrawing();
   }
 
+  history.reset();
+  density.reset();
   CloseWindow();
+  trace::Stop();
 
   return 0;
 }
@@ -0,0 +1,120 @@
+#include "pyramid.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "raymath.h"
+
+namespace reefscape {
+
+namespace {
+
+// Largest distance, in pixels, that a level may merge points across
+constexpr float kMaxError = 2.0f;
+
+}  // namespace
+
+TrailPyramid::TrailPyramid(int segments)
+    : buckets_per_ring_(
+          std::max(std::clamp(segments, 1, Trail::kMaxSegments) / 2, 1)) {
+  for (auto &level : levels_) {
+    level.emplace(segments);
+  }
+}
+
+void TrailPyramid::Clear() {
+  for (auto &level : levels_) {
+    level->Clear();
+  }
+  buckets_.fill(Bucket{});
+  spreads_.fill(Spread{});
+  size_ = 0;
+}
+
+void TrailPyramid::Push(float x, double y, float z, float voltage) {
+  if (size_ > 0 && y < last_time_) {
+    Clear();
+  }
+  if (size_ == 0) {
+    first_time_ = y;
+  }
+  last_time_ = y;
+  ++size_;
+
+  levels_[0]->Push(x, y, z, voltage);
+
+  int bucket_size = 1;
+  for (int i = 1; i < kLevels; ++i) {
+    bucket_size *= kFactor;
+
+    Bucket &bucket = buckets_[i];
+    Extreme extreme{x, y, z, voltage, bucket.count};
+    if (bucket.count == 0 || z < bucket.lowest.z) {
+      bucket.lowest = extreme;
+    }
+    if (bucket.count == 0 || z > bucket.highest.z) {
+      bucket.highest = extreme;
+    }
+    bucket.min_x = bucket.count == 0 ? x : std::min(bucket.min_x, x);
+    bucket.max_x = bucket.count == 0 ? x : std::max(bucket.max_x, x);
+
+    if (++bucket.count == bucket_size) {
+      bool lowest_first = bucket.lowest.index < bucket.highest.index;
+      const Extreme &first = lowest_first ? bucket.lowest : bucket.highest;
+      const Extreme &second = lowest_first ? bucket.highest : bucket.lowest;
+      levels_[i]->Push(first.x, first.y, first.z, first.voltage);
+      levels_[i]->Push(second.x, second.y, second.z, second.voltage);
+      bucket.count = 0;
+
+      Spread &spread = spreads_[i];
+      spread.current = std::max(spread.current, bucket.max_x - bucket.min_x);
+      if (++spread.buckets == buckets_per_ring_) {
+        spread.previous = spread.current;
+        spread.current = 0;
+        spread.buckets = 0;
+      }
+    }
+  }
+}
+
+int TrailPyramid::Level(const Camera &camera) const {
+  if (size_ < 2) {
+    return 0;
+  }
+
+  // NOTE(hayden): The newest point is drawn at the origin, so the error is
+  // measured there, where the camera usually looks
+  float height = static_cast<float>(GetScreenHeight());
+  float units_per_pixel;
+  if (camera.projection == CAMERA_ORTHOGRAPHIC) {
+    units_per_pixel = camera.fovy / height;
+  } else {
+    float distance = std::max(Vector3Length(camera.position), 0.1f);
+    float view = 2 * distance * std::tan(camera.fovy * DEG2RAD / 2);
+    units_per_pixel = view / height;
+  }
+
+  double max_error = kMaxError * units_per_pixel;
+  double spacing = (last_time_ - first_time_) / (size_ - 1);
+  double merged = spacing * kFactor;
+  int level = 0;
+  while (level + 1 < kLevels && merged <= max_error &&
+         spreads_[level + 1].Max() <= max_error) {
+    ++level;
+    merged *= kFactor;
+  }
+  return level;
+}
+
+void TrailPyramid::Draw(const Camera &camera, float thickness) {
+  int level = Level(camera);
+  double until = std::numeric_limits<double>::infinity();
+  for (int i = level; i < kLevels; ++i) {
+    double from = levels_[i]->OldestTime();
+    levels_[i]->Draw(thickness, last_time_, from, until);
+    until = std::min(until, from);
+  }
+}
+
+}  // namespace reefscape
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <optional>
+
+#include "raylib.h"
+#include "trail.hh"
+
+namespace reefscape {
+
+// A trail kept at several levels of detail, so that a long history can be
+// drawn at a bounded cost. Level 0 holds every point; each coarser level
+// keeps only the lowest and highest point (by z) of every `kFactor` times as
+// many, and so spans `kFactor` times as long in the same number of segments.
+//
+// Every level is updated as points arrive, in constant time per point. When
+// drawing, the coarsest level whose detail is finer than a couple of pixels
+// draws the recent past, and each coarser level draws only the history older
+// than the finer levels hold. A level's detail is the larger of the time it
+// merges and the spread in x of the points it merged, since only the extremes
+// in z are kept exactly.
+class TrailPyramid {
+ public:
+  static constexpr int kLevels = 7;
+  static constexpr int kFactor = 4;
+
+  // Each level holds at most `segments` segments
+  explicit TrailPyramid(int segments);
+
+  // Removes every point
+  void Clear();
+
+  // Adds a point at (`x`, `y`, `z`), where `y` is its time. Points must arrive
+  // in time order; a point older than the last starts the history over.
+  void Push(float x, double y, float z, float voltage);
+
+  // Number of points since the history started
+  long long Size() const { return size_; }
+
+  // Draws the history as seen by `camera`, `thickness` pixels wide, with the
+  // newest point at the origin and older points below. Must be called in 3D
+  // mode.
+  void Draw(const Camera &camera, float thickness);
+
+ private:
+  struct Extreme {
+    float x;
+    double y;
+    float z;
+    float voltage;
+    // Index within the bucket, to keep the two extremes in time order
+    int index;
+  };
+
+  // The points of a coarse level not yet complete
+  struct Bucket {
+    int count = 0;
+    Extreme lowest;
+    Extreme highest;
+    float min_x;
+    float max_x;
+  };
+
+  // Largest spread in x of the buckets merged into a level. Spreads are
+  // tracked over two generations, each as long as the ring, so the larger
+  // covers at least every bucket the ring still holds.
+  struct Spread {
+    float current = 0;
+    float previous = 0;
+    int buckets = 0;
+
+    float Max() const { return std::max(current, previous); }
+  };
+
+  // Level of detail to draw the recent past with
+  int Level(const Camera &camera) const;
+
+  // NOTE(hayden): GPU resources are released in the destructor, and trails
+  // cannot be moved, so the levels are constructed in place
+  std::array<std::optional<Trail>, kLevels> levels_;
+  std::array<Bucket, kLevels> buckets_;
+  std::array<Spread, kLevels> spreads_;
+  // Buckets that fill a level's ring, at two points each
+  int buckets_per_ring_;
+
+  long long size_ = 0;
+  double first_time_ = 0;
+  double last_time_ = 0;
+};
+
+}  // namespace reefscape
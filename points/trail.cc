@@ -0,0 +1,255 @@
+#include "trail.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <string>
+
+#include "color.hh"
+#include "raymath.h"
+#include "rlgl.h"
+
+namespace reefscape {
+
+namespace {
+
+const char *const kVertexShader = R"(
+#version 330
+
+in vec3 vertexPosition;
+in vec3 vertexNormal;
+in vec2 vertexTexCoord;
+
+uniform mat4 mvp;
+uniform vec2 resolution;
+uniform float thickness;
+uniform float now;
+uniform vec2 window;
+
+out float voltage;
+
+void main() {
+  // Segments outside of the window collapse to nothing
+  float start = min(vertexPosition.y, vertexNormal.y);
+  float side = start >= window.x && start < window.y ? vertexTexCoord.x : 0.0;
+
+  vec3 position = vec3(vertexPosition.x, vertexPosition.y - now,
+                       vertexPosition.z);
+  vec3 endpoint = vec3(vertexNormal.x, vertexNormal.y - now, vertexNormal.z);
+  vec4 clip = mvp * vec4(position, 1.0);
+  vec4 other = mvp * vec4(endpoint, 1.0);
+
+  // Offset perpendicular to the segment as it appears on screen, scaled by w
+  // so the width is constant after the perspective divide
+  vec2 direction = (other.xy / other.w - clip.xy / clip.w) * resolution;
+  direction = length(direction) > 0.0 ? normalize(direction) : vec2(1.0, 0.0);
+  vec2 normal = vec2(-direction.y, direction.x);
+  clip.xy += normal * side * thickness / resolution * clip.w;
+
+  gl_Position = clip;
+  voltage = vertexTexCoord.y;
+}
+)";
+
+const char *const kFragmentShader = R"(
+in float voltage;
+
+out vec4 finalColor;
+
+void main() {
+  finalColor = vec4(VoltageColor(voltage), 1.0);
+}
+)";
+
+// Vertex buffer indices assigned by UploadMesh
+constexpr int kPositionBuffer = 0;
+constexpr int kTexCoordBuffer = 1;
+constexpr int kNormalBuffer = 2;
+
+// NOTE(hayden): The origin moves up to the newest point once it is this far
+// ahead, so a float resolves recent times to a few millionths of a unit
+constexpr double kMaxSinceOrigin = 64;
+
+}  // namespace
+
+Trail::Trail(int max_segments)
+    : max_segments_(std::clamp(max_segments, 1, kMaxSegments)),
+      positions_(max_segments_ * 4 * 3),
+      other_endpoints_(max_segments_ * 4 * 3),
+      sides_and_voltages_(max_segments_ * 4 * 2) {
+  mesh_.vertexCount = max_segments_ * 4;
+  mesh_.triangleCount = max_segments_ * 2;
+  mesh_.indices = static_cast<unsigned short *>(
+      MemAlloc(max_segments_ * 6 * sizeof(unsigned short)));
+
+  // Two triangles per segment, across its start (0, 1) and end (2, 3)
+  for (int segment = 0; segment < max_segments_; ++segment) {
+    const unsigned short first = segment * 4;
+    const unsigned short quad[] = {
+        first,
+        static_cast<unsigned short>(first + 1),
+        static_cast<unsigned short>(first + 2),
+        static_cast<unsigned short>(first + 1),
+        static_cast<unsigned short>(first + 3),
+        static_cast<unsigned short>(first + 2)};
+    std::memcpy(&mesh_.indices[segment * 6], quad, sizeof(quad));
+  }
+
+  // NOTE(hayden): The vertex buffers are filled from the zeroed CPU arrays
+  // that Upload later copies from, and the mesh lets go of them afterwards so
+  // that the vertices aren't held twice. The indices stay, since DrawMesh
+  // only draws indexed when it has them.
+  mesh_.vertices = positions_.data();
+  mesh_.normals = other_endpoints_.data();
+  mesh_.texcoords = sides_and_voltages_.data();
+  UploadMesh(&mesh_, true);
+  mesh_.vertices = nullptr;
+  mesh_.normals = nullptr;
+  mesh_.texcoords = nullptr;
+
+  material_ = LoadMaterialDefault();
+  std::string fragment_shader =
+      std::string{"#version 330\n"} + kVoltageColor + kFragmentShader;
+  material_.shader =
+      LoadShaderFromMemory(kVertexShader, fragment_shader.c_str());
+  resolution_location_ = GetShaderLocation(material_.shader, "resolution");
+  thickness_location_ = GetShaderLocation(material_.shader, "thickness");
+  now_location_ = GetShaderLocation(material_.shader, "now");
+  window_location_ = GetShaderLocation(material_.shader, "window");
+}
+
+Trail::~Trail() {
+  UnloadMaterial(material_);
+  UnloadMesh(mesh_);
+}
+
+void Trail::Clear() {
+  filled_ = 0;
+  next_slot_ = 0;
+  dirty_begin_ = 0;
+  dirty_count_ = 0;
+  last_point_.reset();
+}
+
+void Trail::Push(float x, double y, float z, float voltage) {
+  if (filled_ == 0 || y - origin_ > kMaxSinceOrigin) {
+    Rebase(y);
+  }
+  Vector3 position{x, static_cast<float>(y - origin_), z};
+
+  // NOTE(hayden): The first point after a break still takes a slot, with an
+  // invisible segment, so the trail always spans the same number of points
+  WriteSlot(next_slot_, last_point_, position);
+  last_point_ = Point{position, voltage};
+
+  if (dirty_count_ == 0) {
+    dirty_begin_ = next_slot_;
+  }
+  dirty_count_ = std::min(dirty_count_ + 1, max_segments_);
+  filled_ = std::min(filled_ + 1, max_segments_);
+  next_slot_ = (next_slot_ + 1) % max_segments_;
+}
+
+void Trail::WriteSlot(int slot, const std::optional<Point> &start,
+                      Vector3 end) {
+  // NOTE(hayden): The shader offsets each vertex perpendicular to the
+  // direction towards the other endpoint, which is reversed at the end of
+  // the segment, so the sides are swapped there to keep the quad untwisted.
+  // Zero sides collapse the quad to nothing.
+  Vector3 begin = start ? start->position : end;
+  float voltage = start ? start->voltage : 0;
+  float side = start ? 1 : 0;
+
+  const Vector3 endpoints[] = {begin, begin, end, end};
+  const Vector3 others[] = {end, end, begin, begin};
+  const float sides[] = {-side, side, side, -side};
+
+  for (int i = 0; i < 4; ++i) {
+    int vertex = slot * 4 + i;
+    std::memcpy(&positions_[vertex * 3], &endpoints[i], sizeof(Vector3));
+    std::memcpy(&other_endpoints_[vertex * 3], &others[i], sizeof(Vector3));
+    sides_and_voltages_[vertex * 2] = sides[i];
+    sides_and_voltages_[vertex * 2 + 1] = voltage;
+  }
+}
+
+void Trail::Upload(int first, int count) {
+  int vertex = first * 4;
+  int vertices = count * 4;
+  UpdateMeshBuffer(mesh_, kPositionBuffer, &positions_[vertex * 3],
+                   vertices * 3 * sizeof(float), vertex * 3 * sizeof(float));
+  UpdateMeshBuffer(mesh_, kNormalBuffer, &other_endpoints_[vertex * 3],
+                   vertices * 3 * sizeof(float), vertex * 3 * sizeof(float));
+  UpdateMeshBuffer(mesh_, kTexCoordBuffer, &sides_and_voltages_[vertex * 2],
+                   vertices * 2 * sizeof(float), vertex * 2 * sizeof(float));
+}
+
+void Trail::Rebase(double origin) {
+  float shift = static_cast<float>(origin - origin_);
+  origin_ = origin;
+  if (filled_ == 0) {
+    return;
+  }
+
+  for (int vertex = 0; vertex < filled_ * 4; ++vertex) {
+    positions_[vertex * 3 + 1] -= shift;
+    other_endpoints_[vertex * 3 + 1] -= shift;
+  }
+  if (last_point_) {
+    last_point_->position.y -= shift;
+  }
+
+  // NOTE(hayden): Every filled slot changed, so all of them are uploaded
+  dirty_begin_ = 0;
+  dirty_count_ = filled_;
+}
+
+double Trail::OldestTime() const {
+  if (filled_ == 0) {
+    return std::numeric_limits<double>::infinity();
+  }
+
+  // Once the ring is full, the oldest slot is the next to be overwritten
+  int oldest = filled_ == max_segments_ ? next_slot_ : 0;
+  return origin_ + positions_[oldest * 4 * 3 + 1];
+}
+
+void Trail::Draw(float thickness, double now, double from, double until) {
+  if (dirty_count_ > 0) {
+    // The dirty slots wrap around the end of the ring at most once
+    int before_end = std::min(dirty_count_, max_segments_ - dirty_begin_);
+    Upload(dirty_begin_, before_end);
+    if (dirty_count_ > before_end) {
+      Upload(0, dirty_count_ - before_end);
+    }
+    dirty_count_ = 0;
+  }
+
+  if (filled_ == 0) {
+    return;
+  }
+
+  float resolution[] = {static_cast<float>(GetScreenWidth()),
+                        static_cast<float>(GetScreenHeight())};
+  SetShaderValue(material_.shader, resolution_location_, resolution,
+                 SHADER_UNIFORM_VEC2);
+  SetShaderValue(material_.shader, thickness_location_, &thickness,
+                 SHADER_UNIFORM_FLOAT);
+  // NOTE(hayden): Times are passed relative to the origin, like the points
+  float relative_now = static_cast<float>(now - origin_);
+  SetShaderValue(material_.shader, now_location_, &relative_now,
+                 SHADER_UNIFORM_FLOAT);
+  float window[] = {static_cast<float>(from - origin_),
+                    static_cast<float>(until - origin_)};
+  SetShaderValue(material_.shader, window_location_, window,
+                 SHADER_UNIFORM_VEC2);
+
+  // NOTE(hayden): Only the filled slots are drawn; which way a quad winds
+  // depends on the view, so culling is disabled
+  mesh_.triangleCount = filled_ * 2;
+  rlDisableBackfaceCulling();
+  DrawMesh(mesh_, material_, MatrixIdentity());
+  rlEnableBackfaceCulling();
+}
+
+}  // namespace reefscape
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <optional>
+#include <vector>
+
+#include "raylib.h"
+
+namespace reefscape {
+
+// A trail through the most recent points, drawn as a single ribbon mesh. The
+// y coordinate of each point is its time, and grows with each point. Times
+// are stored as floats relative to an origin that follows the newest point,
+// so the recent past keeps its resolution however long the trail has run.
+// Each segment is a quad that a vertex shader widens to a constant thickness
+// on screen, and the fragment shader colors by voltage, so drawing any number
+// of segments is one draw call.
+//
+// Segments live in a ring of fixed slots in a persistent vertex buffer. A
+// new point overwrites the oldest slot, and only slots written since the last
+// draw are uploaded, so the per-frame cost scales with the new points rather
+// than the length of the trail.
+class Trail {
+ public:
+  // NOTE(hayden): Vertices are indexed with 16 bits, four per segment
+  static constexpr int kMaxSegments = 65536 / 4;
+
+  explicit Trail(int max_segments);
+
+  Trail(const Trail &) = delete;
+  Trail &operator=(const Trail &) = delete;
+
+  ~Trail();
+
+  // Removes every segment
+  void Clear();
+
+  // Extends the trail to (`x`, `y`, `z`), coloring the new segment by the
+  // previous point's `voltage` in volts
+  void Push(float x, double y, float z, float voltage);
+
+  // Leaves a gap before the next point
+  void Break() { last_point_.reset(); }
+
+  // Number of segments, including gaps
+  int Size() const { return filled_; }
+
+  // Time of the oldest point, or infinity if there are none
+  double OldestTime() const;
+
+  // Uploads new segments and draws the segments starting between the times
+  // `from` and `until`, `thickness` pixels wide. Each point is drawn `now -
+  // time` below the origin, so the newest is nearest. Must be called in 3D
+  // mode.
+  void Draw(float thickness, double now, double from, double until);
+
+ private:
+  struct Point {
+    Vector3 position;
+    float voltage;
+  };
+
+  // Writes a segment into `slot`; an invisible one if `start` is empty
+  void WriteSlot(int slot, const std::optional<Point> &start, Vector3 end);
+
+  // Uploads `count` slots beginning at `first`, without wrapping
+  void Upload(int first, int count);
+
+  // Moves the origin of time to `origin`, shifting every stored point
+  void Rebase(double origin);
+
+  int max_segments_;
+  // Slots in use, which are always the first `filled_`
+  int filled_ = 0;
+  int next_slot_ = 0;
+  // Slots written since the last upload, beginning at `dirty_begin_`
+  int dirty_begin_ = 0;
+  int dirty_count_ = 0;
+  std::optional<Point> last_point_;
+  // Time that the stored y coordinates are relative to
+  double origin_ = 0;
+
+  // Each vertex holds its own endpoint as its position and the segment's
+  // other endpoint as its normal; its texture coordinates are the side of
+  // the ribbon it lies on and the voltage
+  std::vector<float> positions_;
+  std::vector<float> other_endpoints_;
+  std::vector<float> sides_and_voltages_;
+
+  Mesh mesh_{};
+  Material material_{};
+  int resolution_location_;
+  int thickness_location_;
+  int now_location_;
+  int window_location_;
+};
+
+}  // namespace reefscape
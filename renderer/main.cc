@@ -1,20 +1,91 @@
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "SampleHistory.hh"
 #include "au/units/inches.hh"
 #include "ntcore_cpp.h"
 #include "pubsub.hh"
 #include "raylib.h"
+#include "raymath.h"
 #include "render.hh"
 #include "render_units.hh"
+#include "sample.hh"
+#include "telemetry.hh"
+#include "trace.hh"
 
 using namespace reefscape;
 
-int main() {
-  auto client = nt::CreateInstance();
-  nt::StartClient4(client, "client");
-  nt::SetServer(client, "127.0.0.1", 5810);
+struct Options : ViewerOptions {
+  // Draws every member of an ensemble run instead of one robot
+  bool ensemble = false;
+};
+
+Options ParseOptions(int argc, char *argv[]) {
+  Options options;
 
-  Subscriber subscriber{client};
+  for (int i = 1; i < argc; ++i) {
+    if (ParseViewerOption(argc, argv, i, options)) {
+      continue;
+    }
+    if (std::string_view{argv[i]} == "--ensemble") {
+      options.ensemble = true;
+    } else {
+      std::cerr << "usage: " << argv[0] << ' ' << kViewerUsage
+                << " [--ensemble]" << std::endl;
+      std::exit(EXIT_FAILURE);
+    }
+  }
+
+  return options;
+}
+
+int main(int argc, char *argv[]) {
+  Options options = ParseOptions(argc, argv);
+  if (!options.trace.empty()) {
+    trace::Start(options.trace, "renderer");
+  }
+
+  std::optional<TelemetryLog> log;
+  std::optional<TelemetryPlayer> player;
+  std::optional<Subscriber> subscriber;
+  std::optional<EnsembleSubscriber> ensemble;
+  if (options.ensemble) {
+    auto client = nt::CreateInstance();
+    nt::StartClient4(client, "client");
+    nt::SetServer(client, "127.0.0.1", 5810);
+    ensemble.emplace(client);
+  } else if (!options.replay.empty()) {
+    log.emplace(options.replay);
+    player.emplace(*log, options.speed);
+  } else if (!options.shm.empty()) {
+    subscriber.emplace(options.shm);
+  } else {
+    auto client = nt::CreateInstance();
+    nt::StartClient4(client, "client");
+    nt::SetServer(client, "127.0.0.1", 5810);
+    // NOTE(hayden): Every tick is kept, so motion can be interpolated between
+    // them however NT batches their delivery
+    subscriber.emplace(client, 1024);
+  }
+  std::vector<TimestampedSample> received;
+  SampleHistory history;
+  // NOTE(hayden): Long enough to cover a late NT flush, so the presented
+  // time rarely runs past the newest sample
+  PresentationClock clock{(au::milli(au::seconds))(50)};
 
-  Init({pixels(360.0), pixels(640.0), "Reefscape Elevator Simulator", 60});
+  const int fps = 60;
+  // NOTE(hayden): Still often enough to stay responsive to keys
+  const int idle_fps = 10;
+  Init({pixels(360.0), pixels(640.0), "Reefscape Elevator Simulator", fps});
+  // NOTE(hayden): GPU resources must be released before the window closes
+  std::optional<Robot> robot;
+  robot.emplace();
 
   auto camera_omega = (au::degrees / au::second)(12.0);
 
@@ -24,20 +95,95 @@ int main() {
 
   TextWriter writer;
 
+  // P pauses the camera, which lets the frame rate drop while nothing moves
+  bool spin = true;
+  bool idle = false;
+  double last_position = 0;
+
+  std::vector<Displacement> ensemble_positions;
+  std::size_t ensemble_columns = 1;
+
   while (!WindowShouldClose()) {
     auto elapsed_time = au::seconds(GetFrameTime());
-    camera.position = SpinZ(camera.position, camera_omega * elapsed_time);
+    if (IsKeyPressed(KEY_P)) {
+      spin = !spin;
+    }
+    if (spin) {
+      camera.position = SpinZ(camera.position, camera_omega * elapsed_time);
+    }
+
+    if (ensemble) {
+      ensemble_positions.clear();
+      for (double position : ensemble->Latest()) {
+        ensemble_positions.push_back(au::meters(position));
+      }
+
+      // NOTE(hayden): The camera backs away as the grid grows, so the whole
+      // ensemble stays in view
+      std::size_t columns = static_cast<std::size_t>(
+          std::ceil(std::sqrt(ensemble_positions.size())));
+      columns = std::max<std::size_t>(columns, 1);
+      if (columns != ensemble_columns) {
+        float scale = static_cast<float>(columns) / ensemble_columns;
+        Vector3 offset = Vector3Subtract(camera.position, camera.target);
+        camera.position =
+            Vector3Add(camera.target, Vector3Scale(offset, scale));
+        ensemble_columns = columns;
+      }
+
+      RenderEnsemble(camera, *robot, ensemble_positions);
+      writer.Reset();
+      writer.Write(std::to_string(ensemble_positions.size()) + " elevators");
+      continue;
+    }
+
+    // Samples are presented a little late and in step with the frame clock,
+    // at the playback speed when replaying
+    Time presentation_elapsed = elapsed_time;
+    if (player) {
+      HandleReplayKeys(*player);
+      for (const Sample &played : player->Advance(elapsed_time)) {
+        history.Add(played);
+      }
+      presentation_elapsed = elapsed_time * player->Speed();
+    } else {
+      subscriber->Drain(received);
+      for (const auto &timestamped : received) {
+        history.Add(timestamped.sample);
+      }
+    }
+
+    Sample sample{};
+    if (!history.Empty()) {
+      sample = history.At(
+          clock.Advance(presentation_elapsed, history.Newest()));
+    }
+
+    // NOTE(hayden): A still frame needs no redrawing, but the window must
+    // keep handling events, so it redraws at a lower rate instead
+    bool still = !spin && std::abs(sample.position - last_position) < 1e-6;
+    last_position = sample.position;
+    if (still != idle) {
+      idle = still;
+      SetTargetFPS(idle ? idle_fps : fps);
+    }
 
-    auto position = subscriber.Position();
-    auto velocity = subscriber.Velocity();
-    auto voltage = subscriber.Voltage();
+    auto position = sample.State().Position();
+    auto velocity = sample.State().Velocity();
+    auto voltage = sample.Voltage();
 
-    Render(camera, position);
+    Render(camera, *robot, position);
     writer.Reset();
     writer.Write(std::to_string(position.in(au::meters)) + "m");
     writer.Write(std::to_string(velocity.in(au::meters / au::second)) + "m/s");
     writer.Write(std::to_string(voltage.in(au::volts)) + "V");
+    if (player) {
+      writer.Write(std::to_string(player->Time().in(au::seconds)) + "s (" +
+                   std::to_string(player->Speed()) + "x)");
+    }
   }
 
+  robot.reset();
   CloseWindow();
+  trace::Stop();
 }
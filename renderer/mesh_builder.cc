@@ -0,0 +1,115 @@
+#include "mesh_builder.hh"
+
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+#include "raymath.h"
+
+namespace reefscape {
+
+namespace {
+
+// Components of `vector`, indexed by axis
+float &Axis(Vector3 &vector, int axis) {
+  return axis == 0 ? vector.x : axis == 1 ? vector.y : vector.z;
+}
+
+// Corner of a box on the sides given by the signs of `u` and `v` along the
+// axes after `axis`, and by `sign` along `axis` itself
+Vector3 Corner(Vector3 center, Vector3 half, int axis, float sign, float u,
+               float v) {
+  Vector3 corner = center;
+  Axis(corner, axis) += sign * Axis(half, axis);
+  Axis(corner, (axis + 1) % 3) += u * Axis(half, (axis + 1) % 3);
+  Axis(corner, (axis + 2) % 3) += v * Axis(half, (axis + 2) % 3);
+  return corner;
+}
+
+}  // namespace
+
+void MeshBuilder::Triangle(Vector3 a, Vector3 b, Vector3 c, Vector3 outward,
+                           Color color) {
+  Vector3 normal = Vector3CrossProduct(Vector3Subtract(b, a),
+                                       Vector3Subtract(c, a));
+  if (Vector3DotProduct(normal, outward) < 0) {
+    std::swap(b, c);
+  }
+
+  vertices_.insert(vertices_.end(), {a, b, c});
+  colors_.insert(colors_.end(), {color, color, color});
+}
+
+void MeshBuilder::Quad(Vector3 a, Vector3 b, Vector3 c, Vector3 d,
+                       Vector3 outward, Color color) {
+  Triangle(a, b, c, outward, color);
+  Triangle(a, c, d, outward, color);
+}
+
+void MeshBuilder::Box(Vector3 center, Vector3 size, Color color) {
+  Vector3 half = Vector3Scale(size, 0.5f);
+  for (int axis = 0; axis < 3; ++axis) {
+    for (float sign : {-1.0f, 1.0f}) {
+      Vector3 outward{};
+      Axis(outward, axis) = sign;
+      Quad(Corner(center, half, axis, sign, -1, -1),
+           Corner(center, half, axis, sign, 1, -1),
+           Corner(center, half, axis, sign, 1, 1),
+           Corner(center, half, axis, sign, -1, 1), outward, color);
+    }
+  }
+}
+
+void MeshBuilder::BoxEdges(Vector3 center, Vector3 size, Color color) {
+  Vector3 half = Vector3Scale(size, 0.5f);
+  for (int axis = 0; axis < 3; ++axis) {
+    for (float u : {-1.0f, 1.0f}) {
+      for (float v : {-1.0f, 1.0f}) {
+        lines_.push_back({Corner(center, half, axis, -1, u, v),
+                          Corner(center, half, axis, 1, u, v), color});
+      }
+    }
+  }
+}
+
+void MeshBuilder::Cylinder(Vector3 start, Vector3 end, float radius,
+                           int sides, Color color) {
+  Vector3 axis = Vector3Normalize(Vector3Subtract(end, start));
+  Vector3 first = Vector3Normalize(Vector3Perpendicular(axis));
+  Vector3 second = Vector3CrossProduct(axis, first);
+
+  auto radial = [&](int side) {
+    float angle = 2 * PI * side / sides;
+    return Vector3Add(Vector3Scale(first, std::cos(angle)),
+                      Vector3Scale(second, std::sin(angle)));
+  };
+
+  for (int side = 0; side < sides; ++side) {
+    Vector3 here = Vector3Scale(radial(side), radius);
+    Vector3 next = Vector3Scale(radial(side + 1), radius);
+    Vector3 outward = Vector3Add(here, next);
+
+    Quad(Vector3Add(start, here), Vector3Add(start, next),
+         Vector3Add(end, next), Vector3Add(end, here), outward, color);
+    Triangle(start, Vector3Add(start, here), Vector3Add(start, next),
+             Vector3Negate(axis), color);
+    Triangle(end, Vector3Add(end, here), Vector3Add(end, next), axis, color);
+  }
+}
+
+Mesh MeshBuilder::Build() const {
+  Mesh mesh{};
+  mesh.vertexCount = static_cast<int>(vertices_.size());
+  mesh.triangleCount = mesh.vertexCount / 3;
+  mesh.vertices = static_cast<float *>(
+      MemAlloc(vertices_.size() * sizeof(Vector3)));
+  std::memcpy(mesh.vertices, vertices_.data(),
+              vertices_.size() * sizeof(Vector3));
+  mesh.colors = static_cast<unsigned char *>(
+      MemAlloc(colors_.size() * sizeof(Color)));
+  std::memcpy(mesh.colors, colors_.data(), colors_.size() * sizeof(Color));
+  UploadMesh(&mesh, false);
+  return mesh;
+}
+
+}  // namespace reefscape
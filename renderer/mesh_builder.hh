@@ -0,0 +1,49 @@
+#pragma once
+
+#include <vector>
+
+#include "raylib.h"
+
+namespace reefscape {
+
+struct Line {
+  Vector3 start;
+  Vector3 end;
+  Color color;
+};
+
+// Collects colored shapes into a single mesh, so geometry that never changes
+// shape can be uploaded once and drawn with one call. Outlines are collected
+// separately, since meshes only hold triangles.
+class MeshBuilder {
+ public:
+  // Adds a box centered at `center`
+  void Box(Vector3 center, Vector3 size, Color color);
+
+  // Adds the twelve edges of a box centered at `center`
+  void BoxEdges(Vector3 center, Vector3 size, Color color);
+
+  // Adds a capped cylinder from `start` to `end`
+  void Cylinder(Vector3 start, Vector3 end, float radius, int sides,
+                Color color);
+
+  // Uploads the triangles as a mesh, which the caller must unload
+  Mesh Build() const;
+
+  const std::vector<Line> &Lines() const { return lines_; }
+
+ private:
+  // Adds a triangle, wound to face `outward`
+  void Triangle(Vector3 a, Vector3 b, Vector3 c, Vector3 outward,
+                Color color);
+
+  // Adds a convex quad with corners in order around it
+  void Quad(Vector3 a, Vector3 b, Vector3 c, Vector3 d, Vector3 outward,
+            Color color);
+
+  std::vector<Vector3> vertices_;
+  std::vector<Color> colors_;
+  std::vector<Line> lines_;
+};
+
+}  // namespace reefscape
@@ -1,12 +1,16 @@
 #include "render.hh"
 
 #include <cassert>
+#include <cmath>
+#include <vector>
 
 #include "au/units/degrees.hh"
 #include "raylib.h"
 #include "raymath.h"
 #include "render_units.hh"
+#include "rlgl.h"
 #include "robot.hh"
+#include "trace.hh"
 #include "units.hh"
 
 namespace reefscape {
@@ -36,15 +40,54 @@ Camera InitCamera(const UnitVector3 &position, const UnitVector3 &target,
   return camera;
 }
 
-void DrawStandoff(Vector3 start, Displacement length, Displacement radius) {
+namespace {
+
+const char *const kInstancedVertexShader = R"(
+#version 330
+
+in vec3 vertexPosition;
+in vec4 vertexColor;
+in mat4 instanceTransform;
+
+uniform mat4 mvp;
+
+out vec4 fragColor;
+
+void main() {
+  fragColor = vertexColor;
+  gl_Position = mvp * instanceTransform * vec4(vertexPosition, 1.0);
+}
+)";
+
+const char *const kInstancedFragmentShader = R"(
+#version 330
+
+in vec4 fragColor;
+
+out vec4 finalColor;
+
+void main() { finalColor = fragColor; }
+)";
+
+Vector3 Size(Displacement x, Displacement y, Displacement z) {
+  return {x.in(raylib_units), y.in(raylib_units), z.in(raylib_units)};
+}
+
+void AddOutlinedBox(MeshBuilder &builder, Vector3 center, Vector3 size,
+                    Color color) {
+  builder.Box(center, size, color);
+  builder.BoxEdges(center, size, BLACK);
+}
+
+void AddStandoff(MeshBuilder &builder, Vector3 start, Displacement length,
+                 Displacement radius) {
   Vector3 end = start;
   end.z -= length.in(raylib_unit);
-  DrawCylinderEx(start, end, radius.in(raylib_unit), radius.in(raylib_unit), 16,
-                 BLACK);
+  builder.Cylinder(start, end, radius.in(raylib_unit), 16, BLACK);
 }
 
-void DrawStandoffs(Vector3 origin, Displacement length, Displacement radius,
-                   Displacement inner_width) {
+void AddStandoffs(MeshBuilder &builder, Vector3 origin, Displacement length,
+                  Displacement radius, Displacement inner_width) {
   origin.y -= au::inches(0.5).in(raylib_unit);
   origin.z -= (kTubeHeight / 2).in(raylib_units);
 
@@ -56,18 +99,18 @@ void DrawStandoffs(Vector3 origin, Displacement length, Displacement radius,
   Vector3 right = origin;
   right.x += half_offset.in(raylib_unit);
 
-  DrawStandoff(left, length, radius);
-  DrawStandoff(right, length, radius);
+  AddStandoff(builder, left, length, radius);
+  AddStandoff(builder, right, length, radius);
 
   left.y -= au::inches(1.0).in(raylib_unit);
   right.y -= au::inches(1.0).in(raylib_unit);
 
-  DrawStandoff(left, length, radius);
-  DrawStandoff(right, length, radius);
+  AddStandoff(builder, left, length, radius);
+  AddStandoff(builder, right, length, radius);
 }
 
-void DrawVerticalTubes(Vector3 origin, Displacement length,
-                       Displacement inner_width) {
+void AddVerticalTubes(MeshBuilder &builder, Vector3 origin,
+                      Displacement length, Displacement inner_width) {
   origin.y += (length / 2).in(raylib_unit);
 
   Displacement half_offset = (inner_width / 2 + kTubeWidth / 2);
@@ -78,44 +121,37 @@ void DrawVerticalTubes(Vector3 origin, Displacement length,
   Vector3 right = origin;
   right.x += half_offset.in(raylib_unit);
 
-  DrawCube(left, kTubeWidth.in(raylib_unit), length.in(raylib_unit),
-           kTubeHeight.in(raylib_unit), k5112Green);
-  DrawCubeWires(left, kTubeWidth.in(raylib_unit), length.in(raylib_unit),
-                kTubeHeight.in(raylib_unit), BLACK);
-  DrawCube(right, kTubeWidth.in(raylib_unit), length.in(raylib_unit),
-           kTubeHeight.in(raylib_unit), k5112Green);
-  DrawCubeWires(right, kTubeWidth.in(raylib_unit), length.in(raylib_unit),
-                kTubeHeight.in(raylib_unit), BLACK);
+  Vector3 size = Size(kTubeWidth, length, kTubeHeight);
+  AddOutlinedBox(builder, left, size, k5112Green);
+  AddOutlinedBox(builder, right, size, k5112Green);
 }
 
-void DrawHorizontalTubeUpZ(Vector3 origin, Displacement length) {
+void AddHorizontalTubeUpZ(MeshBuilder &builder, Vector3 origin,
+                          Displacement length) {
   origin.y += (kTubeHeight / 2).in(raylib_units);
   origin.z += (kTubeWidth / 2).in(raylib_units);
-  DrawCube(origin, length.in(raylib_unit), kTubeHeight.in(raylib_unit),
-           kTubeWidth.in(raylib_unit), k5112Green);
-  DrawCubeWires(origin, length.in(raylib_unit), kTubeHeight.in(raylib_unit),
-                kTubeWidth.in(raylib_unit), BLACK);
+  AddOutlinedBox(builder, origin, Size(length, kTubeHeight, kTubeWidth),
+                 k5112Green);
 }
 
-void DrawHorizontalTubeUpX(Vector3 origin, Displacement length) {
+void AddHorizontalTubeUpX(MeshBuilder &builder, Vector3 origin,
+                          Displacement length) {
   origin.y += (kTubeHeight / 2).in(raylib_units);
   origin.x += (kTubeWidth / 2).in(raylib_units);
-  DrawCube(origin, kTubeWidth.in(raylib_units), kTubeHeight.in(raylib_units),
-           length.in(raylib_units), k5112Green);
-  DrawCubeWires(origin, kTubeWidth.in(raylib_units),
-                kTubeHeight.in(raylib_units), length.in(raylib_units), BLACK);
+  AddOutlinedBox(builder, origin, Size(kTubeWidth, kTubeHeight, length),
+                 k5112Green);
 }
 
-void DrawHorizontalTubeFlat(Vector3 origin, Displacement length) {
+void AddHorizontalTubeFlat(MeshBuilder &builder, Vector3 origin,
+                           Displacement length) {
   origin.y += (kTubeWidth / 2).in(raylib_units);
-  DrawCube(origin, length.in(raylib_units), kTubeWidth.in(raylib_units),
-           kTubeHeight.in(raylib_units), k5112Green);
-  DrawCubeWires(origin, length.in(raylib_units), kTubeWidth.in(raylib_units),
-                kTubeHeight.in(raylib_units), BLACK);
+  AddOutlinedBox(builder, origin, Size(length, kTubeWidth, kTubeHeight),
+                 k5112Green);
 }
 
-void DrawThinTubesBack(Vector3 origin, Displacement thin_tube_length,
-                       Displacement inner_width) {
+void AddThinTubesBack(MeshBuilder &builder, Vector3 origin,
+                      Displacement thin_tube_length,
+                      Displacement inner_width) {
   origin.y += (kThinTubeWidth / 2).in(raylib_units);
   origin.z -= (thin_tube_length / 2 - kTubeHeight / 2).in(raylib_units);
 
@@ -127,136 +163,254 @@ void DrawThinTubesBack(Vector3 origin, Displacement thin_tube_length,
   Vector3 right = origin;
   right.x += half_offset.in(raylib_unit);
 
-  DrawCube(left, kThinTubeWidth.in(raylib_units),
-           kThinTubeHeight.in(raylib_units), thin_tube_length.in(raylib_units),
-           k5112Green);
-  DrawCubeWires(left, kThinTubeWidth.in(raylib_units),
-                kThinTubeHeight.in(raylib_units),
-                thin_tube_length.in(raylib_units), BLACK);
-  DrawCube(right, kThinTubeWidth.in(raylib_units),
-           kThinTubeHeight.in(raylib_units), thin_tube_length.in(raylib_units),
-           k5112Green);
-  DrawCubeWires(right, kThinTubeWidth.in(raylib_units),
-                kThinTubeHeight.in(raylib_units),
-                thin_tube_length.in(raylib_units), BLACK);
+  Vector3 size = Size(kThinTubeWidth, kThinTubeHeight, thin_tube_length);
+  AddOutlinedBox(builder, left, size, k5112Green);
+  AddOutlinedBox(builder, right, size, k5112Green);
 }
 
-void DrawThinTubeAcross(Vector3 origin, Displacement length) {
+void AddThinTubeAcross(MeshBuilder &builder, Vector3 origin,
+                       Displacement length) {
   origin.y += (kThinTubeWidth / 2).in(raylib_units);
   origin.z += (kThinTubeHeight / 2).in(raylib_units);
 
-  DrawCube(origin, length.in(raylib_units), kThinTubeWidth.in(raylib_units),
-           kThinTubeHeight.in(raylib_units), k5112Green);
-  DrawCubeWires(origin, length.in(raylib_units),
-                kThinTubeWidth.in(raylib_units),
-                kThinTubeHeight.in(raylib_units), BLACK);
+  AddOutlinedBox(builder, origin,
+                 Size(length, kThinTubeWidth, kThinTubeHeight), k5112Green);
 }
 
-void DrawStageOne(Vector3 origin) {
-  DrawHorizontalTubeFlat(origin, kStageOneInnerWidth + 2 * kTubeWidth);
+void AddStageOne(MeshBuilder &builder, Vector3 origin) {
+  AddHorizontalTubeFlat(builder, origin,
+                        kStageOneInnerWidth + 2 * kTubeWidth);
   origin.y += kTubeWidth.in(raylib_units);
-  DrawVerticalTubes(origin, kStageOneHeight, kStageOneInnerWidth);
+  AddVerticalTubes(builder, origin, kStageOneHeight, kStageOneInnerWidth);
   origin.y += kStageOneHeight.in(raylib_units);
-  DrawStandoffs(origin, kStageOneStandoffLength, kStageOneStandoffRadius,
-                kStageOneInnerWidth + kTubeWidth);
+  AddStandoffs(builder, origin, kStageOneStandoffLength,
+               kStageOneStandoffRadius, kStageOneInnerWidth + kTubeWidth);
   origin.y -= kTubeHeight.in(raylib_units);
   origin.z -= kTubeHeight.in(raylib_units);
   origin.z -= kStageOneStandoffLength.in(raylib_units);
-  DrawHorizontalTubeUpZ(origin, kStageOneInnerWidth + 2 * kTubeWidth);
+  AddHorizontalTubeUpZ(builder, origin, kStageOneInnerWidth + 2 * kTubeWidth);
 }
 
-void DrawStageTwo(Vector3 origin) {
-  DrawHorizontalTubeFlat(origin, kStageTwoInnerWidth);
-  DrawVerticalTubes(origin, kStageTwoHeight, kStageTwoInnerWidth);
+void AddStageTwo(MeshBuilder &builder, Vector3 origin) {
+  AddHorizontalTubeFlat(builder, origin, kStageTwoInnerWidth);
+  AddVerticalTubes(builder, origin, kStageTwoHeight, kStageTwoInnerWidth);
   origin.y += kStageTwoHeight.in(raylib_units);
-  DrawThinTubesBack(origin, kStageTwoThinTubeLength, kStageTwoInnerWidth);
+  AddThinTubesBack(builder, origin, kStageTwoThinTubeLength,
+                   kStageTwoInnerWidth);
   origin.z -= kStageTwoThinTubeLength.in(raylib_units);
-  DrawThinTubeAcross(origin, kStageTwoInnerWidth + 2 * kTubeWidth);
+  AddThinTubeAcross(builder, origin, kStageTwoInnerWidth + 2 * kTubeWidth);
 }
 
-void DrawStageThree(Vector3 origin) {
-  DrawHorizontalTubeFlat(origin, kStageThreeInnerWidth);
-  DrawVerticalTubes(origin, kStageThreeHeight, kStageThreeInnerWidth);
+void AddStageThree(MeshBuilder &builder, Vector3 origin) {
+  AddHorizontalTubeFlat(builder, origin, kStageThreeInnerWidth);
+  AddVerticalTubes(builder, origin, kStageThreeHeight, kStageThreeInnerWidth);
   origin.y += (kStageThreeHeight - kTubeWidth).in(raylib_units);
-  DrawHorizontalTubeFlat(origin, kStageThreeInnerWidth);
+  AddHorizontalTubeFlat(builder, origin, kStageThreeInnerWidth);
 }
 
-void DrawCarriage(Vector3 origin) {
-  DrawHorizontalTubeFlat(origin, kCarriageInnerWidth);
-  DrawVerticalTubes(origin, kCarriageHeight, kCarriageInnerWidth);
+void AddCarriage(MeshBuilder &builder, Vector3 origin) {
+  AddHorizontalTubeFlat(builder, origin, kCarriageInnerWidth);
+  AddVerticalTubes(builder, origin, kCarriageHeight, kCarriageInnerWidth);
   origin.y += (kCarriageHeight - kTubeWidth).in(raylib_units);
-  DrawHorizontalTubeFlat(origin, kCarriageInnerWidth);
+  AddHorizontalTubeFlat(builder, origin, kCarriageInnerWidth);
 }
 
-void DrawBase(Vector3 origin) {
-  DrawCube(origin, kBaseSize.in(raylib_units), kBaseThickness.in(raylib_units),
-           kBaseSize.in(raylib_units), GRAY);
-  DrawCubeWires(origin, kBaseSize.in(raylib_units),
-                kBaseThickness.in(raylib_units), kBaseSize.in(raylib_units),
-                BLACK);
+void AddBase(MeshBuilder &builder, Vector3 origin) {
+  AddOutlinedBox(builder, origin, Size(kBaseSize, kBaseThickness, kBaseSize),
+                 GRAY);
 }
 
-void DrawFrameTubes(Vector3 origin) {
+void AddFrameTubes(MeshBuilder &builder, Vector3 origin) {
   Vector3 frame_origin;
   frame_origin = origin;
   frame_origin.z += kFrameTubeDistance.in(raylib_units);
-  DrawHorizontalTubeUpZ(frame_origin, kFrameTubeLength);
+  AddHorizontalTubeUpZ(builder, frame_origin, kFrameTubeLength);
   frame_origin = origin;
   frame_origin.z -= kFrameTubeDistance.in(raylib_units);
   frame_origin.z -= kTubeWidth.in(raylib_units);
-  DrawHorizontalTubeUpZ(frame_origin, kFrameTubeLength);
+  AddHorizontalTubeUpZ(builder, frame_origin, kFrameTubeLength);
   frame_origin = origin;
   frame_origin.x += kFrameTubeDistance.in(raylib_units);
-  DrawHorizontalTubeUpX(frame_origin, kFrameTubeLength - 2 * kTubeWidth);
+  AddHorizontalTubeUpX(builder, frame_origin,
+                       kFrameTubeLength - 2 * kTubeWidth);
   frame_origin = origin;
   frame_origin.x -= kFrameTubeDistance.in(raylib_units);
   frame_origin.x -= kTubeWidth.in(raylib_units);
-  DrawHorizontalTubeUpX(frame_origin, kFrameTubeLength - 2 * kTubeWidth);
+  AddHorizontalTubeUpX(builder, frame_origin,
+                       kFrameTubeLength - 2 * kTubeWidth);
 }
 
-void DrawRobot(Displacement elevator_position) {
-  Vector3 origin = {0, 0, 0};
+}  // namespace
 
-  Vector3 base_origin = origin;
+Robot::Part Robot::Bake(const MeshBuilder &builder) {
+  return {LoadModelFromMesh(builder.Build()), builder.Lines()};
+}
+
+void Robot::DrawPart(const Part &part, Vector3 offset) {
+  DrawModel(part.model, offset, 1.0f, WHITE);
+
+  // NOTE(hayden): Meshes only hold triangles, so outlines go through the
+  // line batch, which is still one draw for every part
+  rlBegin(RL_LINES);
+  for (const Line &line : part.outline) {
+    rlColor4ub(line.color.r, line.color.g, line.color.b, line.color.a);
+    rlVertex3f(line.start.x + offset.x, line.start.y + offset.y,
+               line.start.z + offset.z);
+    rlVertex3f(line.end.x + offset.x, line.end.y + offset.y,
+               line.end.z + offset.z);
+  }
+  rlEnd();
+}
+
+Robot::Robot() {
+  Vector3 base_origin = {0, 0, 0};
   base_origin.y += kBaseToFloor.in(raylib_units);
-  DrawBase(base_origin);
 
   Vector3 frame_origin = base_origin;
   frame_origin.y += kFrameToBase.in(raylib_units);
-  DrawFrameTubes(frame_origin);
-
-  Vector3 stage_one_origin = frame_origin;
-  stage_one_origin.y += kStageOneToFrame.in(raylib_units);
-  DrawStageOne(stage_one_origin);
-
-  double elevator_percent = elevator_position / kTotalTravel;
-
-  Vector3 stage_two_origin = stage_one_origin;
-  stage_two_origin.y +=
-      (kStageTwoToStageOneAtBottom + elevator_percent * kStageTwoTravel)
-          .in(raylib_units);
-  DrawStageTwo(stage_two_origin);
-
-  Vector3 stage_three_origin = stage_two_origin;
-  stage_three_origin.y +=
-      (kStageThreeToStageTwoAtBottom + elevator_percent * kStageThreeTravel)
-          .in(raylib_units);
-  DrawStageThree(stage_three_origin);
-
-  Vector3 carriage_origin = stage_three_origin;
-  carriage_origin.y +=
-      (kCarriageToStageThreeAtBottom + elevator_percent * kCarriageTravel)
-          .in(raylib_units);
-  DrawCarriage(carriage_origin);
+
+  stage_one_origin_ = frame_origin;
+  stage_one_origin_.y += kStageOneToFrame.in(raylib_units);
+
+  MeshBuilder fixed;
+  AddBase(fixed, base_origin);
+  AddFrameTubes(fixed, frame_origin);
+  AddStageOne(fixed, stage_one_origin_);
+  fixed_ = Bake(fixed);
+
+  // NOTE(hayden): Moving stages are built at their own origin and offset
+  // when drawn
+  MeshBuilder stage_two;
+  AddStageTwo(stage_two, {});
+  stages_[0] = {Bake(stage_two), kStageTwoToStageOneAtBottom.in(raylib_units),
+                kStageTwoTravel.in(raylib_units)};
+
+  MeshBuilder stage_three;
+  AddStageThree(stage_three, {});
+  stages_[1] = {Bake(stage_three),
+                kStageThreeToStageTwoAtBottom.in(raylib_units),
+                kStageThreeTravel.in(raylib_units)};
+
+  MeshBuilder carriage;
+  AddCarriage(carriage, {});
+  stages_[2] = {Bake(carriage),
+                kCarriageToStageThreeAtBottom.in(raylib_units),
+                kCarriageTravel.in(raylib_units)};
+
+  instanced_material_ = LoadMaterialDefault();
+  Shader &shader = instanced_material_.shader;
+  shader =
+      LoadShaderFromMemory(kInstancedVertexShader, kInstancedFragmentShader);
+  shader.locs[SHADER_LOC_MATRIX_MODEL] =
+      GetShaderLocationAttrib(shader, "instanceTransform");
 }
 
-void Render(const Camera &camera, Displacement elevator_position) {
+Robot::~Robot() {
+  UnloadMaterial(instanced_material_);
+  UnloadModel(fixed_.model);
+  for (const Stage &stage : stages_) {
+    UnloadModel(stage.part.model);
+  }
+}
+
+void Robot::Draw(Displacement elevator_position) const {
+  trace::Scope scope{"DrawRobot"};
+  DrawPart(fixed_, {0, 0, 0});
+
+  float elevator_percent = elevator_position / kTotalTravel;
+
+  // Each stage rides on the one below it
+  Vector3 origin = stage_one_origin_;
+  for (const Stage &stage : stages_) {
+    origin.y += stage.bottom + elevator_percent * stage.travel;
+    DrawPart(stage.part, origin);
+  }
+}
+
+void Robot::DrawInstanced(
+    std::span<const Vector3> origins,
+    std::span<const Displacement> elevator_positions) const {
+  trace::Scope scope{"DrawInstanced"};
+  assert(origins.size() == elevator_positions.size());
+  const int instances = static_cast<int>(origins.size());
+  if (instances == 0) {
+    return;
+  }
+
+  // NOTE(hayden): Transforms are laid out part by part: the fixed parts,
+  // stage one's origin, then each moving stage, which rides on the one below
+  transforms_.resize(origins.size() * (stages_.size() + 2));
+  for (int i = 0; i < instances; ++i) {
+    transforms_[i] = MatrixTranslate(origins[i].x, origins[i].y, origins[i].z);
+  }
+  DrawMeshInstanced(fixed_.model.meshes[0], instanced_material_,
+                    transforms_.data(), instances);
+
+  for (int i = 0; i < instances; ++i) {
+    Vector3 origin = Vector3Add(origins[i], stage_one_origin_);
+    transforms_[instances + i] = MatrixTranslate(origin.x, origin.y, origin.z);
+  }
+  for (std::size_t stage = 0; stage < stages_.size(); ++stage) {
+    Matrix *below = &transforms_[(stage + 1) * instances];
+    Matrix *above = below + instances;
+    for (int i = 0; i < instances; ++i) {
+      float elevator_percent = elevator_positions[i] / kTotalTravel;
+      float rise = stages_[stage].bottom +
+                   elevator_percent * stages_[stage].travel;
+      above[i] = below[i];
+      above[i].m13 += rise;
+    }
+  }
+  for (std::size_t stage = 0; stage < stages_.size(); ++stage) {
+    DrawMeshInstanced(stages_[stage].part.model.meshes[0], instanced_material_,
+                      &transforms_[(stage + 2) * instances], instances);
+  }
+}
+
+std::span<const Vector3> Robot::GridOrigins(int count) const {
+  if (static_cast<int>(grid_origins_.size()) != count) {
+    int columns = static_cast<int>(std::ceil(std::sqrt(count)));
+    float spacing = EnsembleSpacing().in(raylib_units);
+
+    grid_origins_.clear();
+    for (int i = 0; i < count; ++i) {
+      float column = i % columns - (columns - 1) / 2.0f;
+      float row = i / columns - (columns - 1) / 2.0f;
+      grid_origins_.push_back({column * spacing, 0, row * spacing});
+    }
+  }
+  return grid_origins_;
+}
+
+void Render(const Camera &camera, const Robot &robot,
+            Displacement elevator_position) {
+  trace::Scope scope{"Render"};
+  BeginDrawing();
+  ClearBackground(WHITE);
+  BeginMode3D(camera);
+  robot.Draw(elevator_position);
+  DrawPlane(Vector3{0, 0, 0}, Vector2{1000, 1000}, LIGHTGRAY);
+  EndMode3D();
+  // NOTE(hayden): Includes the swap, and so any wait for the frame limit
+  trace::Scope end_drawing{"EndDrawing"};
+  EndDrawing();
+}
+
+Displacement EnsembleSpacing() { return 1.5 * kBaseSize; }
+
+void RenderEnsemble(const Camera &camera, const Robot &robot,
+                    std::span<const Displacement> elevator_positions) {
+  trace::Scope scope{"RenderEnsemble"};
+  auto origins =
+      robot.GridOrigins(static_cast<int>(elevator_positions.size()));
+
   BeginDrawing();
   ClearBackground(WHITE);
   BeginMode3D(camera);
-  DrawRobot(elevator_position);
+  robot.DrawInstanced(origins, elevator_positions);
   DrawPlane(Vector3{0, 0, 0}, Vector2{1000, 1000}, LIGHTGRAY);
   EndMode3D();
+  trace::Scope end_drawing{"EndDrawing"};
   EndDrawing();
 }
 
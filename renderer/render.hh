@@ -1,5 +1,11 @@
 #pragma once
 
+#include <array>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "mesh_builder.hh"
 #include "raylib.h"
 #include "units.hh"
 
@@ -25,7 +31,71 @@ struct UnitVector3 {
 Camera InitCamera(const UnitVector3 &position, const UnitVector3 &target,
                   Angle fov);
 
-void Render(const Camera &camera, Displacement elevator_position);
+// The robot's geometry, built and uploaded once, so drawing it only moves the
+// stages. Must be created after the window opens and destroyed before it
+// closes.
+class Robot {
+ public:
+  Robot();
+
+  Robot(const Robot &) = delete;
+  Robot &operator=(const Robot &) = delete;
+
+  ~Robot();
+
+  // Draws the robot with the elevator at `elevator_position`
+  void Draw(Displacement elevator_position) const;
+
+  // Draws a robot at each of `origins` with its elevator at the matching
+  // position. Each part is one instanced draw for every robot, and outlines
+  // are left out.
+  void DrawInstanced(std::span<const Vector3> origins,
+                     std::span<const Displacement> elevator_positions) const;
+
+  // Origins of `count` robots in a square grid centered on the origin, which
+  // are only rebuilt when the count changes
+  std::span<const Vector3> GridOrigins(int count) const;
+
+ private:
+  struct Part {
+    Model model;
+    std::vector<Line> outline;
+  };
+
+  // A stage that moves with the elevator, relative to the stage below it, in
+  // raylib units
+  struct Stage {
+    Part part;
+    float bottom;
+    float travel;
+  };
+
+  static Part Bake(const MeshBuilder &builder);
+
+  static void DrawPart(const Part &part, Vector3 offset);
+
+  // The base, frame tubes and stage one, which never move
+  Part fixed_;
+  Vector3 stage_one_origin_;
+  // Stages two and three, then the carriage
+  std::array<Stage, 3> stages_;
+
+  // Vertex colors with a transform per instance
+  Material instanced_material_;
+  // NOTE(hayden): Reused between frames, so drawing doesn't allocate
+  mutable std::vector<Matrix> transforms_;
+  mutable std::vector<Vector3> grid_origins_;
+};
+
+void Render(const Camera &camera, const Robot &robot,
+            Displacement elevator_position);
+
+// Renders a robot per position in a square grid centered on the origin
+void RenderEnsemble(const Camera &camera, const Robot &robot,
+                    std::span<const Displacement> elevator_positions);
+
+// Distance between the centers of neighboring robots in the ensemble grid
+Displacement EnsembleSpacing();
 
 Vector3 SpinZ(const Vector3 &position, Angle angle);
 
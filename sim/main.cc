@@ -1,10 +1,28 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
 #include <thread>
+#include <utility>
+#include <vector>
 
+#include "AffineEnsembleSim.hh"
 #include "AffineSystemSim.hh"
+#include "AsyncPublisher.hh"
 #include "Elevator.hh"
+#include "LQR.hh"
+#include "LatencyHistogram.hh"
+#include "LoopScheduler.hh"
 #include "Motor.hh"
 #include "MotorSystem.hh"
+#include "MotorSystemConstants.hh"
 #include "au/units/amperes.hh"
 #include "au/units/inches.hh"
 #include "au/units/pounds_mass.hh"
@@ -12,6 +30,9 @@
 #include "ntcore_cpp.h"
 #include "pubsub.hh"
 #include "robot.hh"
+#include "sample.hh"
+#include "telemetry.hh"
+#include "trace.hh"
 #include "trajectory.hh"
 #include "units.hh"
 
@@ -19,30 +40,181 @@ using namespace reefscape;
 using State = PositionVelocityState;
 using Input = VoltageInput;
 
-int main() {
+struct Options {
+  // NOTE(hayden): Headless runs use a virtual clock and stop after `duration`
+  bool headless = false;
+  Time duration = au::seconds(600);
+  // Telemetry log to write, if any
+  std::string record;
+  // Shared-memory ring for local viewers, in addition to NT
+  std::string shm;
+  LoopSchedulerOptions scheduler;
+  // Chrome trace file to append to, if any
+  std::string trace;
+  // Number of elevators to run alongside, with payloads spread across them
+  int ensemble = 0;
+};
+
+Options ParseOptions(int argc, char *argv[]) {
+  Options options;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg = argv[i];
+    if (arg == "--headless") {
+      options.headless = true;
+    } else if (arg == "--duration" && i + 1 < argc) {
+      options.duration = au::seconds(std::atof(argv[++i]));
+    } else if (arg == "--record" && i + 1 < argc) {
+      options.record = argv[++i];
+    } else if (arg == "--shm" && i + 1 < argc) {
+      options.shm = argv[++i];
+    } else if (arg == "--realtime") {
+      options.scheduler.realtime = true;
+    } else if (arg == "--cpu" && i + 1 < argc) {
+      options.scheduler.cpu = std::atoi(argv[++i]);
+    } else if (arg == "--mlock") {
+      options.scheduler.lock_memory = true;
+    } else if (arg == "--trace" && i + 1 < argc) {
+      options.trace = argv[++i];
+    } else if (arg == "--ensemble" && i + 1 < argc) {
+      options.ensemble = std::max(0, std::atoi(argv[++i]));
+    } else {
+      std::cerr << "usage: " << argv[0]
+                << " [--headless] [--duration SECONDS] [--record FILE]"
+                   " [--shm NAME] [--realtime] [--cpu N] [--mlock]"
+                   " [--trace FILE] [--ensemble N]"
+                << std::endl;
+      std::exit(EXIT_FAILURE);
+    }
+  }
+
+  return options;
+}
+
+std::atomic<bool> stop_requested = false;
+
+// Stages of a tick, each timed into its own latency histogram
+enum Stage {
+  kProfile,
+  kFeedback,
+  kLimitVoltage,
+  kUpdate,
+  kClamp,
+  kPublish,
+  kEnsemble,
+  kStages
+};
+
+const char *const kStageNames[kStages] = {
+    "profile", "feedback", "limit_voltage", "update",
+    "clamp",   "publish",  "ensemble"};
+
+// NOTE(hayden): Ensemble positions only feed the renderer, so they are
+// published about once per frame rather than every tick
+const int kEnsemblePublishPeriod = 16;
+
+int main(int argc, char *argv[]) {
+  Options options = ParseOptions(argc, argv);
+
+  // NOTE(hayden): Stopping on SIGINT lets the telemetry log flush and the loop
+  // statistics print
+  std::signal(SIGINT, [](int) { stop_requested = true; });
+
   // TODO(hayden): Move quantity makers to separate namespace?
   Elevator elevator{units::gear_ratio(5), 0.5 * au::inches(1.273),
                     au::pounds_mass(30),  au::amperes(120),
                     kTotalTravel,         Motor::KrakenX60FOC() * 2};
 
-  auto server = nt::CreateInstance();
-  nt::StartServer(server, "", "127.0.0.1", 0, 5810);
-  Publisher publisher{server};
+  // NOTE(hayden): NT is published from its own thread, so a network stall
+  // can't delay a tick
+  std::optional<AsyncPublisher> publisher;
+  std::optional<EnsemblePublisher> ensemble_publisher;
+  // NOTE(hayden): Headless runs measure throughput, so they skip the timers
+  std::array<LatencyHistogram, kStages> latency;
+  std::optional<LatencyPublisher> latency_publisher;
+  if (!options.headless) {
+    auto server = nt::CreateInstance();
+    nt::StartServer(server, "", "127.0.0.1", 0, 5810);
+    if (options.shm.empty()) {
+      publisher.emplace(Publisher{server});
+    } else {
+      publisher.emplace(Publisher{server, options.shm});
+    }
+    if (options.ensemble > 0) {
+      ensemble_publisher.emplace(server);
+    }
+
+    std::vector<NamedHistogram> histograms;
+    for (int stage = 0; stage < kStages; ++stage) {
+      histograms.push_back({kStageNames[stage], &latency[stage]});
+    }
+    latency_publisher.emplace(server, "/sim/latency", std::move(histograms));
+  }
+  struct StageScope {
+    ScopedTimer timer;
+    trace::Scope trace;
+  };
+  auto time_stage = [&](Stage stage) {
+    return StageScope{
+        ScopedTimer{options.headless ? nullptr : &latency[stage]},
+        trace::Scope{kStageNames[stage]}};
+  };
+
+  if (!options.trace.empty()) {
+    trace::Start(options.trace, "sim");
+  }
+
+  std::optional<TelemetryRecorder> recorder;
+  if (!options.record.empty()) {
+    recorder.emplace(options.record);
+  }
 
   Time time_step = (au::milli(au::seconds))(1);
-  auto wait_time =
-      std::chrono::microseconds(time_step.in<int>(au::micro(au::seconds)));
   // TODO(hayden): Make this a universal constant
   LinearAcceleration gravity = (au::meters / squared(au::second))(-9.81);
 
   AffineSystemSim<State, Input> sim{elevator, gravity, time_step};
+  MotorSystemConstants<units::DisplacementUnit> motor_constants{elevator};
 
-  // TODO(hayden): Implement LQR to find the optimal K
-  auto kP = (au::volts / au::meter)(191.2215);
-  auto kD = (au::volts / (au::meters / au::second))(4.811);
-  Eigen::Matrix<double, Input::Dimension, State::Dimension> K;
-  K << kP.in(au::volts / au::meter),
-      kD.in(au::volts / (au::meters / au::second));
+  // NOTE(hayden): Gains are tabulated from the carriage alone up to carrying a
+  // game piece, so picking one up only changes the interpolated gain
+  GearRatio gear_ratios[] = {elevator.gear_ratio};
+  auto Q = CostMatrix<State::Dimension>({0.05, 1.0});
+  auto R = CostMatrix<Input::Dimension>({12.0});
+  ElevatorGainSchedule gain_schedule = MakeElevatorGainSchedule(
+      elevator, gear_ratios, elevator.mass, elevator.mass + au::pounds_mass(5),
+      11, time_step, Q, R);
+  // TODO(hayden): Determine payload mass based on events
+  Mass payload_mass = elevator.mass;
+
+  // Every member tracks the same reference with the gain scheduled for its own
+  // payload, so members past the end of the schedule show its limits
+  std::vector<Elevator> members;
+  for (int member = 0; member < options.ensemble; ++member) {
+    double fraction =
+        options.ensemble > 1 ? member / (options.ensemble - 1.0) : 0.0;
+    Elevator variant = elevator;
+    variant.mass = variant.mass + fraction * au::pounds_mass(10);
+    members.push_back(variant);
+  }
+  std::optional<AffineEnsembleSim<State, Input>> ensemble;
+  EnsembleMotorConstants ensemble_constants;
+  Eigen::ArrayXd ensemble_kP(options.ensemble);
+  Eigen::ArrayXd ensemble_kD(options.ensemble);
+  Eigen::ArrayXd ensemble_min = Eigen::ArrayXd::Zero(options.ensemble);
+  Eigen::ArrayXd ensemble_max = Eigen::ArrayXd::Constant(
+      options.ensemble, elevator.max_travel.in(au::meters));
+  if (options.ensemble > 0) {
+    ensemble.emplace(members, gravity, time_step);
+    ensemble_constants =
+        EnsembleMotorConstants::From<units::DisplacementUnit>(members);
+    for (int member = 0; member < options.ensemble; ++member) {
+      auto K = gain_schedule.Gain(0, members[member].mass);
+      ensemble_kP[member] = K(0, 0);
+      ensemble_kD[member] = K(0, 1);
+    }
+  }
+  int tick = 0;
 
   // TODO(hayden): Determine if it is possible to avoid explicit declaration
   TrapezoidTrajectory<units::DisplacementUnit> profile{elevator};
@@ -52,34 +224,148 @@ int main() {
 
   State reference = bottom;
   State goal = top;
+  State plan_goal = goal;
+  auto plan = profile.Plan(reference, plan_goal);
+  Time plan_time = au::seconds(0);
+
+  std::optional<LoopScheduler> scheduler;
+  if (!options.headless) {
+    scheduler.emplace(time_step, options.scheduler);
+  }
 
   Time total_sim_time = au::seconds(0);
+  // NOTE(hayden): Paced runs step by the period the scheduler measured, so the
+  // sim keeps pace with the wall clock however late a wakeup is. The sim
+  // rounds each step to its quantum and the remainder is carried into the
+  // next tick, so every clock advances by the step the state actually took.
+  Time period = time_step;
+  Time carried_time = au::seconds(0);
+  auto start_wall_time = std::chrono::steady_clock::now();
 
-  while (true) {
-    // TODO(hayden): Determine goal based on events
-    auto cycle_time = au::fmod(total_sim_time, au::seconds(6));
-    if (cycle_time < au::seconds(3)) {
-      goal = top;
-    } else {
-      goal = bottom;
+  while (!stop_requested &&
+         (!options.headless || total_sim_time < options.duration)) {
+    Time tick_time = sim.Quantize(period + carried_time);
+    carried_time = period + carried_time - tick_time;
+
+    {
+      auto timer = time_stage(kProfile);
+      // TODO(hayden): Determine goal based on events
+      auto cycle_time = au::fmod(total_sim_time, au::seconds(6));
+      if (cycle_time < au::seconds(3)) {
+        goal = top;
+      } else {
+        goal = bottom;
+      }
+
+      if (goal.vector != plan_goal.vector) {
+        plan_goal = goal;
+        plan = profile.Plan(reference, plan_goal);
+        plan_time = au::seconds(0);
+      }
+      plan_time += tick_time;
+      reference = plan.Sample(plan_time);
+    }
+
+    Input input{au::volts(0)};
+    {
+      auto timer = time_stage(kFeedback);
+      State error{reference.vector - sim.State().vector};
+      auto K = gain_schedule.Gain(0, payload_mass);
+      input = K * error.vector + sim.StabilizingInput().vector;
     }
 
-    reference = profile.Calculate(time_step, reference, goal);
-    State error{reference.vector - sim.State().vector};
+    {
+      auto timer = time_stage(kLimitVoltage);
+      input.SetVoltage(LimitVoltage(motor_constants, sim.State().Velocity(),
+                                    input.Voltage()));
+    }
 
-    Input input{K * error.vector + sim.StabilizingInput().vector};
-    auto limited_voltage =
-        LimitVoltage(elevator, sim.State().Velocity(), input.Voltage());
-    Input limited_input{limited_voltage};
-    sim.Update(limited_input);
-    sim.SetState(
-        sim.State().PositionClamped(au::meters(0), elevator.max_travel));
+    {
+      auto timer = time_stage(kUpdate);
+      sim.Update(input, tick_time);
+    }
 
-    State new_state = sim.State();
-    bool at_goal = new_state.At(goal);
-    publisher.Publish(sim.State(), reference, sim.Input(), at_goal);
+    {
+      auto timer = time_stage(kClamp);
+      sim.SetState(
+          sim.State().PositionClamped(au::meters(0), elevator.max_travel));
+    }
+
+    total_sim_time += tick_time;
+
+    {
+      auto timer = time_stage(kPublish);
+      auto sample = Sample::From(total_sim_time, sim.State(), reference,
+                                 sim.Input(), sim.State().At(goal));
+      if (recorder) {
+        if (options.headless) {
+          // NOTE(hayden): Headless runs outpace the writer, and a gap in the
+          // log is worse than a slower run
+          while (!recorder->TryRecord(sample)) {
+            std::this_thread::yield();
+          }
+        } else {
+          recorder->Record(sample);
+        }
+      }
+      if (publisher) {
+        publisher->Publish(sample);
+      }
+    }
+
+    if (ensemble) {
+      auto timer = time_stage(kEnsemble);
+      auto &state = ensemble->State();
+      auto voltage = ensemble->Input().col(0);
+      voltage = ensemble_kP * (reference.vector[0] - state.col(0)) +
+                ensemble_kD * (reference.vector[1] - state.col(1)) +
+                ensemble->StabilizingInput().col(0);
+      LimitVoltage(ensemble_constants, state.col(1), voltage);
+      ensemble->Update(tick_time);
+      ensemble->ClampPosition(ensemble_min, ensemble_max);
+
+      if (ensemble_publisher && tick % kEnsemblePublishPeriod == 0) {
+        const auto &positions = ensemble->State().col(0);
+        ensemble_publisher->Publish(
+            std::span{positions.data(), positions.size()});
+      }
+    }
+    ++tick;
+
+    trace::Counter("voltage", sim.Input().Voltage().in(au::volts));
+
+    if (options.headless) {
+      continue;
+    }
+
+    trace::Scope wait{"wait"};
+    period = scheduler->Wait();
+  }
+
+  trace::Stop();
+
+  std::chrono::duration<double> wall_time =
+      std::chrono::steady_clock::now() - start_wall_time;
+  double sim_seconds = total_sim_time.in(au::seconds);
+  std::cout << sim_seconds << " s simulated in " << wall_time.count()
+            << " s (" << sim_seconds / wall_time.count()
+            << " simulated s per wall s)" << std::endl;
+  if (scheduler) {
+    std::cout << scheduler->Statistics() << std::endl;
+    std::cout << "discretization cache: " << sim.Cache().Hits() << " hits, "
+              << sim.Cache().Misses() << " misses" << std::endl;
+    for (int stage = 0; stage < kStages; ++stage) {
+      std::cout << kStageNames[stage] << ": " << latency[stage] << std::endl;
+    }
+  }
+  if (publisher) {
+    std::cout << publisher->Sent() << " samples sent in "
+              << publisher->Flushes() << " flushes, " << publisher->Dropped()
+              << " dropped" << std::endl;
+  }
 
-    total_sim_time += time_step;
-    std::this_thread::sleep_for(wait_time);
+  if (recorder && recorder->Dropped() != 0) {
+    std::cerr << recorder->Dropped() << " samples dropped from "
+              << options.record << std::endl;
   }
 }
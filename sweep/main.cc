@@ -0,0 +1,298 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "Elevator.hh"
+#include "ElevatorSim.hh"
+#include "Motor.hh"
+#include "MotorSystem.hh"
+#include "MotorSystemConstants.hh"
+#include "au/units/amperes.hh"
+#include "au/units/inches.hh"
+#include "au/units/pounds_mass.hh"
+#include "robot.hh"
+#include "trajectory.hh"
+#include "units.hh"
+
+using namespace reefscape;
+using State = PositionVelocityState;
+using Input = VoltageInput;
+
+// NOTE(hayden): The default point is the robot's elevator, so its
+// discretization is checked at compile time. Travel doesn't affect it.
+constexpr ElevatorDiscretization kRobotDiscretization{
+    Elevator{units::gear_ratio(5), 0.5 * au::inches(1.273),
+             au::pounds_mass(30), au::amperes(120), au::meters(0),
+             Motor::KrakenX60FOC() * 2},
+    (au::meters / squared(au::second))(-9.81), (au::milli(au::seconds))(1)};
+static_assert(kRobotDiscretization.system_velocity_velocity > 0 &&
+                  kRobotDiscretization.system_velocity_velocity < 1,
+              "the discrete velocity pole must be stable");
+static_assert(kRobotDiscretization.stabilizing_voltage > 0 &&
+                  kRobotDiscretization.stabilizing_voltage < 12,
+              "the motors must be able to hold the carriage against gravity");
+
+// Evenly spaced values from `start` to `stop`, written as START[:STOP:COUNT]
+struct Range {
+  double start;
+  double stop;
+  int count;
+
+  double operator[](int i) const {
+    if (count <= 1) {
+      return start;
+    }
+    return start + (stop - start) * i / (count - 1);
+  }
+};
+
+Range ParseRange(std::string_view text) {
+  auto first = text.find(':');
+  if (first == std::string_view::npos) {
+    double value = std::stod(std::string{text});
+    return {value, value, 1};
+  }
+  auto second = text.find(':', first + 1);
+  return {std::stod(std::string{text.substr(0, first)}),
+          std::stod(std::string{text.substr(first + 1, second - first - 1)}),
+          second == std::string_view::npos
+              ? 2
+              : std::stoi(std::string{text.substr(second + 1)})};
+}
+
+struct Options {
+  Range kP{191.2215, 191.2215, 1};
+  Range kD{4.811, 4.811, 1};
+  Range gear_ratio{5, 5, 1};
+  // NOTE(hayden): Ranges are in SI units (meters, kilograms, amperes)
+  Range drum_radius{au::inches(0.5 * 1.273).in(au::meters),
+                    au::inches(0.5 * 1.273).in(au::meters), 1};
+  Range mass{au::pounds_mass(30.0).in(au::kilo(au::grams)),
+             au::pounds_mass(30.0).in(au::kilo(au::grams)), 1};
+  Range max_current{120, 120, 1};
+  Time duration = au::seconds(3);
+  int threads =
+      std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+  std::string output;
+};
+
+void Usage(const char *program) {
+  std::cerr << "usage: " << program
+            << " [--kP R] [--kD R] [--gear-ratio R] [--drum-radius R]"
+               " [--mass R] [--max-current R] [--duration SECONDS]"
+               " [--threads N] [--output FILE]\n"
+               "  R is START[:STOP:COUNT]"
+            << std::endl;
+  std::exit(EXIT_FAILURE);
+}
+
+Options ParseOptions(int argc, char *argv[]) {
+  Options options;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg = argv[i];
+    if (i + 1 >= argc) {
+      Usage(argv[0]);
+    }
+    std::string_view value = argv[++i];
+    if (arg == "--kP") {
+      options.kP = ParseRange(value);
+    } else if (arg == "--kD") {
+      options.kD = ParseRange(value);
+    } else if (arg == "--gear-ratio") {
+      options.gear_ratio = ParseRange(value);
+    } else if (arg == "--drum-radius") {
+      options.drum_radius = ParseRange(value);
+    } else if (arg == "--mass") {
+      options.mass = ParseRange(value);
+    } else if (arg == "--max-current") {
+      options.max_current = ParseRange(value);
+    } else if (arg == "--duration") {
+      options.duration = au::seconds(std::stod(std::string{value}));
+    } else if (arg == "--threads") {
+      options.threads = std::max(1, std::stoi(std::string{value}));
+    } else if (arg == "--output") {
+      options.output = value;
+    } else {
+      Usage(argv[0]);
+    }
+  }
+
+  return options;
+}
+
+struct Point {
+  double kP;
+  double kD;
+  double gear_ratio;
+  double drum_radius;
+  double mass;
+  double max_current;
+};
+
+struct Metrics {
+  Time rise_time;
+  double overshoot_percent;
+  Time settling_time;
+  quantities::Current peak_current;
+};
+
+// Runs the sim loop for one move up most of the travel and measures its
+// response
+Metrics Evaluate(const Point &point, Time duration) {
+  Elevator elevator{units::gear_ratio(point.gear_ratio),
+                    au::meters(point.drum_radius),
+                    au::kilo(au::grams)(point.mass),
+                    au::amperes(point.max_current),
+                    kTotalTravel,
+                    Motor::KrakenX60FOC() * 2};
+
+  Time time_step = (au::milli(au::seconds))(1);
+  LinearAcceleration gravity = (au::meters / squared(au::second))(-9.81);
+
+  ElevatorSim sim{elevator, gravity, time_step};
+  MotorSystemConstants<units::DisplacementUnit> motor_constants{elevator};
+
+  Eigen::Matrix<double, Input::Dimension, State::Dimension> K;
+  K << point.kP, point.kD;
+
+  TrapezoidTrajectory<units::DisplacementUnit> profile{elevator};
+
+  // NOTE(hayden): The goal is short of the top, since clamping at the top would
+  // hide any overshoot
+  double travel = 0.8 * kTotalTravel.in(au::meters);
+  State goal{au::meters(travel)};
+  State reference{au::meters(0)};
+
+  double rise_start = std::numeric_limits<double>::quiet_NaN();
+  double rise_end = std::numeric_limits<double>::quiet_NaN();
+  double last_unsettled = 0;
+  double max_position = 0;
+  double peak_current = 0;
+
+  int ticks = static_cast<int>(
+      std::round(duration.in(au::seconds) / time_step.in(au::seconds)));
+  for (int tick = 1; tick <= ticks; ++tick) {
+    reference = profile.Calculate(time_step, reference, goal);
+    StateVector<State::Dimension> error =
+        reference.vector - sim.State().vector;
+
+    Input input{K * error + sim.StabilizingInput().vector};
+    auto velocity = sim.State().Velocity();
+    auto limited_voltage =
+        LimitVoltage(motor_constants, velocity, input.Voltage());
+    peak_current = std::max(
+        peak_current,
+        au::abs(reefscape::Current(motor_constants, velocity, limited_voltage))
+            .in(au::amperes));
+    sim.Update(Input{limited_voltage});
+    sim.SetState(
+        sim.State().PositionClamped(au::meters(0), elevator.max_travel));
+
+    double time = tick * time_step.in(au::seconds);
+    double position = sim.State().Position().in(au::meters);
+    max_position = std::max(max_position, position);
+    if (std::isnan(rise_start) && position >= 0.1 * travel) {
+      rise_start = time;
+    }
+    if (std::isnan(rise_end) && position >= 0.9 * travel) {
+      rise_end = time;
+    }
+    if (std::abs(position - travel) > 0.02 * travel) {
+      last_unsettled = time;
+    }
+  }
+
+  double end_time = ticks * time_step.in(au::seconds);
+  return {au::seconds(rise_end - rise_start),
+          100 * (max_position - travel) / travel,
+          au::seconds(last_unsettled < end_time
+                          ? last_unsettled
+                          : std::numeric_limits<double>::quiet_NaN()),
+          au::amperes(peak_current)};
+}
+
+int main(int argc, char *argv[]) {
+  Options options = ParseOptions(argc, argv);
+
+  constexpr std::size_t kAxes = 6;
+  const Range *axes[kAxes] = {&options.kP,         &options.kD,
+                              &options.gear_ratio, &options.drum_radius,
+                              &options.mass,       &options.max_current};
+  std::size_t total_points = 1;
+  for (const Range *axis : axes) {
+    total_points *= std::max(axis->count, 1);
+  }
+
+  auto point_at = [&axes](std::size_t index) {
+    double values[kAxes];
+    for (std::size_t axis = 0; axis < kAxes; ++axis) {
+      int count = std::max(axes[axis]->count, 1);
+      values[axis] = (*axes[axis])[index % count];
+      index /= count;
+    }
+    return Point{values[0], values[1], values[2],
+                 values[3], values[4], values[5]};
+  };
+
+  std::vector<Metrics> results(total_points);
+  std::atomic<std::size_t> next_index = 0;
+  // NOTE(hayden): Points are handed out in chunks so threads rarely contend on
+  // the shared counter
+  const std::size_t chunk_size = 64;
+
+  auto start_wall_time = std::chrono::steady_clock::now();
+
+  std::vector<std::jthread> workers;
+  for (int i = 0; i < options.threads; ++i) {
+    workers.emplace_back([&] {
+      while (true) {
+        std::size_t start = next_index.fetch_add(chunk_size);
+        if (start >= total_points) {
+          return;
+        }
+        std::size_t end = std::min(start + chunk_size, total_points);
+        for (std::size_t index = start; index < end; ++index) {
+          results[index] = Evaluate(point_at(index), options.duration);
+        }
+      }
+    });
+  }
+  workers.clear();
+
+  std::chrono::duration<double> wall_time =
+      std::chrono::steady_clock::now() - start_wall_time;
+
+  std::ofstream file;
+  if (!options.output.empty()) {
+    file.open(options.output);
+  }
+  std::ostream &out = options.output.empty() ? std::cout : file;
+
+  out << "kP,kD,gear_ratio,drum_radius,mass,max_current,rise_time,"
+         "overshoot_percent,settling_time,peak_current\n";
+  for (std::size_t index = 0; index < total_points; ++index) {
+    Point point = point_at(index);
+    const Metrics &metrics = results[index];
+    out << point.kP << ',' << point.kD << ',' << point.gear_ratio << ','
+        << point.drum_radius << ',' << point.mass << ',' << point.max_current
+        << ',' << metrics.rise_time.in(au::seconds) << ','
+        << metrics.overshoot_percent << ','
+        << metrics.settling_time.in(au::seconds) << ','
+        << metrics.peak_current.in(au::amperes) << '\n';
+  }
+
+  std::cerr << total_points << " points on " << options.threads
+            << " threads in " << wall_time.count() << " s ("
+            << total_points / wall_time.count() << " points per s)"
+            << std::endl;
+}